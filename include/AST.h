@@ -283,7 +283,17 @@ void OperationNode<T>::diff(AST<T>* node, const std::string& var_name)
         {
             case OperationNode<T>::Type::MUL: *node = Ld * R + Rd * L;                        break;
             case OperationNode<T>::Type::DIV: *node = (Ld * R - Rd * L) / pow(R, T(2));       break;
-            case OperationNode<T>::Type::POW: *node = pow(L, R) * (Rd * log(L) + R * L / Ld); break;
+            case OperationNode<T>::Type::POW:
+            {
+                // Constant exponents keep the power rule, it stays finite where the base is zero
+                if (IS_NUM(&Rd.simplify()) && (TO_NUM(&Rd)->number == T()))
+                {
+                    *node = R * pow(L, R - T(1)) * Ld;
+                    break;
+                }
+                *node = pow(L, R) * (Rd * log(L) + R * Ld / L);
+                break;
+            }
             default: break;
         }
         break;
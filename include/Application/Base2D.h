@@ -1,36 +1,127 @@
 #ifndef APPLICATION_BASE2D_H
 #define APPLICATION_BASE2D_H
 
-#include "vec2.h"
+#include "DoubleDouble.h"
 
-class Base2D
+enum Precisions
 {
-public:
-    struct Borders final
+    SINGLE_PRECISION,
+    DOUBLE_PRECISION,
+    DOUBLE_DOUBLE_PRECISION,
+};
+
+template <typename T>
+struct Borders2D final
+{
+    T left = T(-1.0);
+    T right = T(1.0);
+    T bottom = T(-1.0);
+    T top = T(1.0);
+
+    Borders2D() = default;
+    Borders2D(const T& left_, const T& right_, const T& bottom_, const T& top_) :
+        left(left_), right(right_), bottom(bottom_), top(top_)
+    {}
+
+    template <typename U>
+    explicit Borders2D(const Borders2D<U>& borders) :
+        left(static_cast<T>(borders.left)), right(static_cast<T>(borders.right)),
+        bottom(static_cast<T>(borders.bottom)), top(static_cast<T>(borders.top))
+    {}
+
+    T width() const
     {
-        float left = -1.0F;
-        float right = 1.0F;
-        float bottom = -1.0F;
-        float top = 1.0F;
+        return right - left;
+    }
 
-        Borders() = default;
-        Borders(float left_, float right_, float bottom_, float top_);
-    };
+    T height() const
+    {
+        return top - bottom;
+    }
+
+    vec2<T> center() const
+    {
+        return vec2<T>((left + right) * T(0.5), (bottom + top) * T(0.5));
+    }
+};
+
+class Base2D
+{
+public:
+    using Borders = Borders2D<float>;
 
     Base2D(const vec2u& size = {});
     virtual ~Base2D() = default;
 
     void setBaseSize(const vec2u& size);
     void setBorders(float bottom_, float top_, float right_left_ratio = 1.0F);
-    Borders getBorders() const;
+    void setPrecision(size_t precision);
+    size_t getPrecision() const;
+
+    template <typename T = float>
+    Borders2D<T> getBorders() const;
+
+    template <typename T = float>
+    vec2<T> Screen2Base(const vec2i& pixel) const;
+
+    template <typename T = float>
+    vec2i Base2Screen(const vec2<T>& point) const;
 
-    vec2f Screen2Base(const vec2i& pixel) const;
-    vec2i Base2Screen(const vec2f& point) const;
     vec2u ScreenSize() const;
 
 protected:
-    Borders borders_;
+    template <typename Function>
+    void visitBorders(const Function& function) const;
+
+    template <typename Function>
+    void updateBorders(const Function& function);
+
+    Borders2D<DoubleDouble> borders_;
+    size_t precision_ = SINGLE_PRECISION;
     vec2u size_;
 };
 
+template <typename T>
+Borders2D<T> Base2D::getBorders() const
+{
+    return Borders2D<T>(borders_);
+}
+
+template <typename T>
+vec2<T> Base2D::Screen2Base(const vec2i& pixel) const
+{
+    Borders2D<T> borders(borders_);
+    return {
+        borders.left + borders.width() * static_cast<T>(pixel.x) / static_cast<T>(size_.x),
+        borders.top - borders.height() * static_cast<T>(pixel.y) / static_cast<T>(size_.y)
+    };
+}
+
+template <typename T>
+vec2i Base2D::Base2Screen(const vec2<T>& point) const
+{
+    Borders2D<T> borders(borders_);
+    return {
+        static_cast<int>(static_cast<double>((point.x - borders.left) / borders.width() * static_cast<T>(size_.x))),
+        static_cast<int>(static_cast<double>((borders.top - point.y) / borders.height() * static_cast<T>(size_.y)))
+    };
+}
+
+template <typename Function>
+void Base2D::visitBorders(const Function& function) const
+{
+    switch (precision_)
+    {
+    case SINGLE_PRECISION:        function(Borders2D<float>(borders_)); break;
+    case DOUBLE_PRECISION:        function(Borders2D<double>(borders_)); break;
+    case DOUBLE_DOUBLE_PRECISION: function(Borders2D<DoubleDouble>(borders_)); break;
+    }
+}
+
+template <typename Function>
+void Base2D::updateBorders(const Function& function)
+{
+    visitBorders([&](const auto& borders) { borders_ = Borders2D<DoubleDouble>(function(borders)); });
+}
+
 #endif // APPLICATION_BASE2D_H
\ No newline at end of file
@@ -20,10 +20,10 @@ public:
 private:
     void updateSize(const vec2u& size);
     void toggleFullScreen();
-    void WheelZooming(float wheel_delta, const vec2f& point);
+    void WheelZooming(float wheel_delta, const vec2i& pixel);
     void MouseMoving(const vec2i& movement);
-    vec2f getLabelPos(const vec2f& point, const vec2f& text_size) const;
-    vec2f getRatio() const;
+    vec2f getLabelPos(const vec2i& pixel, const vec2f& text_size) const;
+    vec2d getRatio() const;
 
     vec2u default_size_;
     const char* title_;
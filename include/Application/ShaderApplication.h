@@ -9,12 +9,17 @@ public:
     ShaderApplication(const vec2u& win_size, const char* font_location, float font_size, const char* win_title = "");
 
     void setRenderImageSize(const vec2u& size);
+    void setRenderImage(const sf::Uint8* pixels);
     sf::Sprite getRenderOutput() const;
 
 protected:
     sf::Shader shader_;
     sf::Sprite sprite_;
     sf::RenderTexture render_texture_;
+
+private:
+    sf::Shader image_shader_;
+    sf::Texture image_texture_;
 };
 
 #endif // APPLICATION_SHADERAPPLICATION_H
\ No newline at end of file
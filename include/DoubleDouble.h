@@ -0,0 +1,144 @@
+#ifndef DOUBLEDOUBLE_H
+#define DOUBLEDOUBLE_H
+
+#include "vec2.h"
+
+#include <cmath>
+
+struct DoubleDouble final
+{
+    double hi = 0.0;
+    double lo = 0.0;
+
+    DoubleDouble() = default;
+    DoubleDouble(double x) : hi(x) {}
+    DoubleDouble(double hi_, double lo_) : hi(hi_), lo(lo_) {}
+
+    explicit operator double() const
+    {
+        return hi + lo;
+    }
+
+    explicit operator float() const
+    {
+        return static_cast<float>(hi + lo);
+    }
+
+    static DoubleDouble TwoSum(double a, double b)
+    {
+        double s = a + b;
+        double v = s - a;
+        return { s, (a - (s - v)) + (b - v) };
+    }
+
+    static DoubleDouble QuickTwoSum(double a, double b)
+    {
+        double s = a + b;
+        return { s, b - (s - a) };
+    }
+
+    static DoubleDouble TwoProd(double a, double b)
+    {
+        double p = a * b;
+        return { p, std::fma(a, b, -p) };
+    }
+
+    DoubleDouble operator + (const DoubleDouble& a) const
+    {
+        DoubleDouble s = TwoSum(hi, a.hi);
+        DoubleDouble t = TwoSum(lo, a.lo);
+        s = QuickTwoSum(s.hi, s.lo + t.hi);
+        return QuickTwoSum(s.hi, s.lo + t.lo);
+    }
+
+    DoubleDouble operator - () const
+    {
+        return { -hi, -lo };
+    }
+
+    DoubleDouble operator - (const DoubleDouble& a) const
+    {
+        return *this + (-a);
+    }
+
+    DoubleDouble operator * (const DoubleDouble& a) const
+    {
+        DoubleDouble p = TwoProd(hi, a.hi);
+        return QuickTwoSum(p.hi, p.lo + (hi * a.lo + lo * a.hi));
+    }
+
+    DoubleDouble operator / (const DoubleDouble& a) const
+    {
+        double q1 = hi / a.hi;
+        DoubleDouble r = *this - a * q1;
+        double q2 = r.hi / a.hi;
+        r = r - a * q2;
+        double q3 = r.hi / a.hi;
+        return QuickTwoSum(q1, q2) + q3;
+    }
+
+    DoubleDouble& operator += (const DoubleDouble& a)
+    {
+        return *this = *this + a;
+    }
+
+    DoubleDouble& operator -= (const DoubleDouble& a)
+    {
+        return *this = *this - a;
+    }
+
+    DoubleDouble& operator *= (const DoubleDouble& a)
+    {
+        return *this = *this * a;
+    }
+
+    DoubleDouble& operator /= (const DoubleDouble& a)
+    {
+        return *this = *this / a;
+    }
+
+    bool operator < (const DoubleDouble& a) const
+    {
+        return (hi < a.hi) || ((hi == a.hi) && (lo < a.lo));
+    }
+
+    bool operator > (const DoubleDouble& a) const
+    {
+        return a < *this;
+    }
+
+    bool operator <= (const DoubleDouble& a) const
+    {
+        return !(a < *this);
+    }
+
+    bool operator >= (const DoubleDouble& a) const
+    {
+        return !(*this < a);
+    }
+
+    bool operator == (const DoubleDouble& a) const
+    {
+        return (hi == a.hi) && (lo == a.lo);
+    }
+
+    bool operator != (const DoubleDouble& a) const
+    {
+        return !(*this == a);
+    }
+};
+
+inline DoubleDouble abs(const DoubleDouble& a)
+{
+    return (a.hi < 0.0) ? -a : a;
+}
+
+inline DoubleDouble floor(const DoubleDouble& a)
+{
+    double hi = std::floor(a.hi);
+    return (hi == a.hi) ? DoubleDouble::QuickTwoSum(hi, std::floor(a.lo)) : DoubleDouble(hi);
+}
+
+typedef vec2<DoubleDouble> vec2dd;
+
+#endif // DOUBLEDOUBLE_H
@@ -3,14 +3,18 @@
 
 #include "Application/ShaderApplication.h"
 #include "AST.h"
+#include "Render/IterationTuner.h"
+#include "Render/Poster.h"
+#include "Render/PreviewQuality.h"
+#include "Render/RenderPipeline.h"
+#include "Render/Renderer.h"
 #include "UI/UI.h"
 
 #include <SFML/Audio.hpp>
 #include <SFML/Graphics.hpp>
+#include <chrono>
 
 using AST = ast::AST<>;
-using ASTz = ast::AST<std::complex<float>>;
-using ASTx = ast::AST<float>;
 
 class Puzabrot final : public ShaderApplication
 {
@@ -18,24 +22,10 @@ public:
     Puzabrot();
 
 private:
-    enum FractalModes
+    enum RenderBackends
     {
-        MAIN,
-        JULIA,
-    };
-
-    enum InputModes
-    {
-        Z_INPUT,
-        XY_INPUT,
-    };
-
-    enum RenderModes
-    {
-        DEFAULT,
-        TRACER,
-        COMPLEX_DOMAIN,
-        KALI,
+        GPU,
+        CPU,
     };
 
     UI ui_;
@@ -46,9 +36,15 @@ private:
         size_t input_mode = Z_INPUT;
         size_t rendering_mode = DEFAULT;
         size_t antialiasing = 0;
+        bool adaptive_antialiasing = false;
+        size_t backend = GPU;
+        bool deep_zoom = false;
+        size_t palette = RAINBOW_PALETTE;
+        bool auto_iteration = false;
         bool sound_mode = false;
         bool showing_grid = false;
         bool showing_trace = false;
+        bool showing_atlas = false;
         bool julia_dragging = false;
         bool right_pressed = false;
     } options_;
@@ -57,6 +53,7 @@ private:
     {
         float limit;
         float frequency;
+        float trace_frequency;
         size_t itrn_max;
         vec2f julia_point;
         vec2f orbit;
@@ -70,6 +67,18 @@ private:
         ASTz z;
     } expr_trees_;
 
+    Formula formula_;
+    Renderer renderer_;
+    RenderPipeline pipeline_;
+    IterationTuner tuner_;
+    PreviewQuality preview_;
+    std::chrono::steady_clock::time_point julia_moved_;
+    bool previewing_ = false;
+    bool tuning_ = false;
+    std::vector<uint8_t> pixels_;
+    sf::Texture palette_texture_;
+    size_t deep_zoom_orbit_size_ = 0;
+
     class Synth;
     std::unique_ptr<Synth> synth_;
 
@@ -81,15 +90,26 @@ private:
     vec2f PointTrace(const vec2f& point, const vec2f& c_point);
     vec2f Mapping(ExprTrees& expr_trees, const vec2f& c, vec2f& z) const;
     void savePicture();
+    void savePoster(const std::string& filename, const vec2u& size);
     AST::Error makeShader();
     void render();
+    void renderPreview();
+    void renderAtlas();
+    void showResult(const RenderResult& result);
+    RenderJob makeRenderJob(const vec2u& size) const;
+    void tuneIterations();
+    void updatePalette();
     int writeShader();
     std::string writeFunctions() const;
     std::string writeColorFunction() const;
     std::string writeInitialization() const;
+    std::string writeInteriorChecking() const;
     std::string writeCalculation() const;
+    std::string writeDerivative() const;
+    std::string writeNewtonStep() const;
     std::string writeChecking() const;
     std::string writeMain() const;
+    std::string writeDeepZoomMain() const;
     int Tree2GLSL(const ASTz& node, std::string* str) const;
     int Tree2GLSL(const ASTx& node, std::string* str) const;
     const char* ASTStringError(const AST::Error& err);
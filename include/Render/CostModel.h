@@ -0,0 +1,59 @@
+#ifndef RENDER_COSTMODEL_H
+#define RENDER_COSTMODEL_H
+
+#include "Application/Base2D.h"
+#include "Render/Formula.h"
+
+#include <deque>
+#include <vector>
+
+constexpr uint32_t COST_CELL_WIDTH = 16;
+constexpr size_t SPANS_PER_THREAD = 4;
+constexpr size_t COST_MODEL_CELLS = size_t(1) << 20;
+
+struct RenderJob;
+
+// Columns of one row of a region rendered as a single piece of work, cost is in seconds. Tiled frames take
+// the rows of a band of tiles together
+struct RowSpan final
+{
+    size_t region = 0;
+    uint32_t row = 0;
+    uint32_t rows = 1;
+    uint32_t row_step = 1;
+    uint32_t col_begin = 0;
+    uint32_t col_end = 0;
+    uint32_t col_step = 1;
+    double cost = 0.0;
+};
+
+// Time per pixel measured on the recent renders of the fractal, looked up by position in the plane to predict the
+// cost of spans of the next render of the same formula. Renders split into tiles or bands are recorded one piece at
+// a time, so the pieces are kept side by side and the newest one covering a point is taken
+class CostModel
+{
+public:
+    bool similar(const RenderJob& job) const;
+    void predict(const RenderJob& job, std::vector<RowSpan>* spans) const;
+    void record(const RenderJob& job, const std::vector<RowSpan>& spans);
+
+private:
+    struct Frame final
+    {
+        Borders2D<DoubleDouble> borders;
+        vec2u size;
+        uint32_t cells_x = 0;
+        std::vector<float> cell_costs;
+        double mean_cost = 0.0;
+    };
+
+    Formula formula_;
+    size_t fractal_mode_ = 0;
+    size_t rendering_mode_ = 0;
+    size_t antialiasing_ = 0;
+    size_t fingerprint_ = 0;
+    std::deque<Frame> frames_;
+    size_t cells_ = 0;
+};
+
+#endif // RENDER_COSTMODEL_H
@@ -0,0 +1,87 @@
+#ifndef RENDER_DISTRIBUTED_H
+#define RENDER_DISTRIBUTED_H
+
+#include "Render/RenderTask.h"
+
+#include <functional>
+#include <string>
+#include <sys/types.h>
+
+constexpr size_t MAX_TILE_ATTEMPTS = 3;
+constexpr size_t TILE_ROWS_IN_FLIGHT = 2;
+constexpr size_t NO_TILE = ~size_t(0);
+constexpr size_t MAX_TASK_SIZE = size_t(1) << 20;
+
+enum MessageTypes : uint32_t
+{
+    TASK_MESSAGE,
+    TILE_MESSAGE,
+    RESULT_MESSAGE,
+    QUIT_MESSAGE,
+};
+
+struct Message final
+{
+    uint32_t type = QUIT_MESSAGE;
+    uint64_t tile = 0;
+    std::string payload;
+};
+
+// Framed messages over a pair of file descriptors, a pipe or a socket
+class Channel
+{
+public:
+    Channel() = default;
+    // Messages with a larger payload are rejected as a broken protocol
+    Channel(int read_fd, int write_fd, size_t max_payload = MAX_TASK_SIZE);
+
+    bool send(const Message& message) const;
+    bool receive(Message* message) const;
+
+    int readFd() const;
+    void close();
+
+private:
+    int read_fd_ = -1;
+    int write_fd_ = -1;
+    size_t max_payload_ = MAX_TASK_SIZE;
+};
+
+// Renders tiles of a task received over the channel until it is told to quit or the channel breaks
+class Worker
+{
+public:
+    static int Run(const Channel& channel);
+};
+
+// Splits a task into tiles, renders them in worker processes and writes them to a PNG file,
+// tiles of a worker that dies are given to another one
+class Coordinator
+{
+public:
+    explicit Coordinator(size_t workers_num);
+    ~Coordinator();
+
+    Coordinator(const Coordinator&) = delete;
+    Coordinator& operator = (const Coordinator&) = delete;
+
+    bool save(const RenderTask& task, const std::string& filename, const std::function<void(double)>& progress = {});
+    size_t retries() const;
+
+private:
+    struct WorkerProcess final
+    {
+        pid_t pid = -1;
+        Channel channel;
+        size_t tile = NO_TILE;
+    };
+
+    bool spawn(WorkerProcess* worker, const std::string& task_text, size_t max_result);
+    void stop(WorkerProcess* worker, bool kill_process);
+    void stopAll();
+
+    std::vector<WorkerProcess> workers_;
+    size_t retries_ = 0;
+};
+
+#endif // RENDER_DISTRIBUTED_H
@@ -0,0 +1,412 @@
+#ifndef RENDER_FORMULA_H
+#define RENDER_FORMULA_H
+
+#include "Render/Polynomial.h"
+
+#include <limits>
+#include <numbers>
+
+using ASTz = ast::AST<std::complex<float>>;
+using ASTx = ast::AST<float>;
+
+enum InputModes
+{
+    Z_INPUT,
+    XY_INPUT,
+};
+
+enum Parities
+{
+    NO_PARITY,
+    EVEN_PARITY,
+    ODD_PARITY,
+};
+
+constexpr size_t FORMULA_MAX_STACK = 64;
+
+class Formula
+{
+public:
+    Formula() = default;
+    explicit Formula(const ASTz& z);
+    Formula(const ASTx& x, const ASTx& y);
+
+    template <typename T>
+    std::complex<T> operator()(const std::complex<T>& z, const std::complex<T>& c) const;
+
+    // Carries the derivatives of z by the real and imaginary parts of the starting point, dz[0] and dz[1], over one step
+    // from z. The constant moves with the starting point when varying_c is set
+    template <typename T>
+    void derivative(const std::complex<T>& z, const std::complex<T>& c, bool varying_c, std::complex<T>* dz) const;
+
+    // Newton step towards a root of the formula in z, or of both parts in x and y
+    template <typename T>
+    std::complex<T> newton(const std::complex<T>& z, const std::complex<T>& c) const;
+
+    // Writes all z with f(z, c) = w and returns their number, none unless the formula is a z^n + g(c)
+    template <typename T>
+    size_t inverse(const std::complex<T>& w, const std::complex<T>& c, std::complex<T>* preimages) const;
+
+    bool operator == (const Formula& formula) const = default;
+
+    bool empty() const;
+    bool hasDerivative() const;
+    size_t inputMode() const;
+    bool isQuadratic() const;
+    size_t inverseBranches() const;
+    size_t fingerprint() const;
+
+    // f(conj z, conj c) = conj f(z, c), the fractal is symmetric about the real axis
+    bool isConjugateSymmetric() const;
+
+    // f(-z, c) = f(z, c) or -f(z, c), Julia sets are symmetric about the origin
+    size_t parity() const;
+
+    // Partial derivatives by z and c, or of x and then y by x, y, cx and cy
+    static std::vector<ASTz> Derivatives(const ASTz& z);
+    static std::vector<ASTx> Derivatives(const ASTx& x, const ASTx& y);
+
+private:
+    enum class Opcode
+    {
+        VARIABLE,
+        NUMBER,
+        ADD,
+        SUB,
+        MUL,
+        DIV,
+        POW,
+        POWI,
+        NEG,
+        FUNCTION,
+    };
+
+    struct Instruction final
+    {
+        Opcode op;
+        size_t arg;
+
+        bool operator == (const Instruction& instruction) const = default;
+    };
+
+    struct Program final
+    {
+        std::vector<Instruction> code;
+        std::vector<std::complex<double>> numbers;
+        size_t stack_depth = 0;
+
+        bool operator == (const Program& program) const = default;
+    };
+
+    template <typename T>
+    void compileDerivatives(const std::vector<ast::AST<T>>& derivatives, const std::vector<std::string>& var_names);
+
+    template <typename T>
+    static bool Compile(const ast::AST<T>& tree, const std::vector<std::string>& var_names, Program* program, size_t depth = 1);
+
+    template <typename T>
+    static std::complex<T> Execute(const Program& program, const std::complex<T>* vars);
+
+    template <typename T>
+    static std::complex<T> CallFunction(size_t func_type, const std::complex<T>& a);
+
+    size_t input_mode_ = Z_INPUT;
+    std::vector<Program> programs_;
+    bool derivative_ = false;
+    bool quadratic_ = false;
+    bool conjugate_symmetric_ = false;
+    size_t parity_ = NO_PARITY;
+    unsigned inverse_degree_ = 0;
+    std::complex<double> inverse_lead_;
+};
+
+// Points of the main cardioid and the period-2 bulb of z^2+c, which never escape
+template <typename T>
+inline bool InsideQuadraticInterior(T x, T y)
+{
+    // Main cardioid
+    T xq = x - T(0.25);
+    T q = xq * xq + y * y;
+    if (q * (q + xq) <= T(0.25) * y * y)
+    {
+        return true;
+    }
+
+    // Period-2 bulb
+    T xp = x + T(1.0);
+    return xp * xp + y * y <= T(0.0625);
+}
+
+template <typename T>
+std::complex<T> Formula::operator()(const std::complex<T>& z, const std::complex<T>& c) const
+{
+    switch (input_mode_)
+    {
+    case Z_INPUT:
+    {
+        std::complex<T> vars[] = { z, c };
+        return Execute(programs_[0], vars);
+    }
+    case XY_INPUT:
+    {
+        std::complex<T> vars[] = { z.real(), z.imag(), c.real(), c.imag() };
+        return { Execute(programs_[0], vars).real(), Execute(programs_[1], vars).real() };
+    }
+    }
+    return {};
+}
+
+template <typename T>
+void Formula::derivative(const std::complex<T>& z, const std::complex<T>& c, bool varying_c, std::complex<T>* dz) const
+{
+    if (!derivative_)
+    {
+        return;
+    }
+
+    if (quadratic_)
+    {
+        dz[0] = T(2.0) * z * dz[0] + (varying_c ? T(1.0) : T(0.0));
+    }
+    else if (input_mode_ == Z_INPUT)
+    {
+        std::complex<T> vars[] = { z, c };
+        dz[0] = Execute(programs_[1], vars) * dz[0] + (varying_c ? Execute(programs_[2], vars) : std::complex<T>());
+    }
+    else
+    {
+        // Programs after the two parts are the rows of the Jacobian, by x, y, cx and cy
+        std::complex<T> vars[] = { z.real(), z.imag(), c.real(), c.imag() };
+        T x[4] = {};
+        T y[4] = {};
+        for (size_t i = 0; i < (varying_c ? 4 : 2); ++i)
+        {
+            x[i] = Execute(programs_[2 + i], vars).real();
+            y[i] = Execute(programs_[6 + i], vars).real();
+        }
+
+        for (size_t k = 0; k < 2; ++k)
+        {
+            dz[k] = { x[0] * dz[k].real() + x[1] * dz[k].imag() + x[2 + k], y[0] * dz[k].real() + y[1] * dz[k].imag() + y[2 + k] };
+        }
+        return;
+    }
+
+    // Holomorphic steps turn both derivatives alike, dz/dy stays i dz/dx
+    dz[1] = std::complex<T>(-dz[0].imag(), dz[0].real());
+}
+
+template <typename T>
+std::complex<T> Formula::newton(const std::complex<T>& z, const std::complex<T>& c) const
+{
+    if (!derivative_)
+    {
+        return std::numeric_limits<T>::quiet_NaN();
+    }
+
+    if (input_mode_ == Z_INPUT)
+    {
+        std::complex<T> vars[] = { z, c };
+        return z - Execute(programs_[0], vars) / Execute(programs_[1], vars);
+    }
+
+    // Solves the Jacobian by x and y against both parts
+    std::complex<T> vars[] = { z.real(), z.imag(), c.real(), c.imag() };
+    const T x = Execute(programs_[0], vars).real();
+    const T y = Execute(programs_[1], vars).real();
+    const T x_x = Execute(programs_[2], vars).real();
+    const T x_y = Execute(programs_[3], vars).real();
+    const T y_x = Execute(programs_[6], vars).real();
+    const T y_y = Execute(programs_[7], vars).real();
+    const T det = x_x * y_y - x_y * y_x;
+    return { z.real() - (y_y * x - x_y * y) / det, z.imag() - (x_x * y - y_x * x) / det };
+}
+
+template <typename T>
+size_t Formula::inverse(const std::complex<T>& w, const std::complex<T>& c, std::complex<T>* preimages) const
+{
+    if (inverse_degree_ == 0)
+    {
+        return 0;
+    }
+
+    // n-th roots of (w - g(c)) / a, g(c) being the value at z = 0
+    const std::complex<T> u = (w - (*this)(std::complex<T>(), c)) / std::complex<T>(inverse_lead_);
+    const T radius = std::pow(std::abs(u), T(1.0) / static_cast<T>(inverse_degree_));
+    const T angle = std::arg(u) / static_cast<T>(inverse_degree_);
+    const T sector = T(2.0) * std::numbers::pi_v<T> / static_cast<T>(inverse_degree_);
+    for (unsigned k = 0; k < inverse_degree_; ++k)
+    {
+        preimages[k] = std::polar(radius, angle + sector * static_cast<T>(k));
+    }
+    return inverse_degree_;
+}
+
+template <typename T>
+bool Formula::Compile(const ast::AST<T>& tree, const std::vector<std::string>& var_names, Program* program, size_t depth)
+{
+    using NodeType = typename ast::ASTNode<T>::Type;
+    using OperationType = typename ast::OperationNode<T>::Type;
+
+    if (depth > FORMULA_MAX_STACK)
+    {
+        return false;
+    }
+    program->stack_depth = std::max(program->stack_depth, depth);
+
+    auto branch = [&tree](size_t ind) { return *static_cast<const ast::AST<T>*>(&tree[ind]); };
+
+    switch (tree.value().get()->NodeType())
+    {
+    case NodeType::NUMBER:
+    {
+        program->code.push_back({ Opcode::NUMBER, program->numbers.size() });
+        program->numbers.emplace_back(static_cast<ast::NumberNode<T>*>(tree.value().get())->number);
+        return true;
+    }
+    case NodeType::VARIABLE:
+    {
+        const auto& name = static_cast<ast::VariableNode<T>*>(tree.value().get())->name;
+        for (size_t i = 0; i < var_names.size(); ++i)
+        {
+            if (var_names[i] == name)
+            {
+                program->code.push_back({ Opcode::VARIABLE, i });
+                return true;
+            }
+        }
+        return false;
+    }
+    case NodeType::FUNCTION:
+    {
+        if (!Compile(branch(0), var_names, program, depth))
+        {
+            return false;
+        }
+        program->code.push_back({ Opcode::FUNCTION, static_cast<size_t>(static_cast<ast::FunctionNode<T>*>(tree.value().get())->type) });
+        return true;
+    }
+    case NodeType::OPERATION:
+    {
+        auto type = static_cast<ast::OperationNode<T>*>(tree.value().get())->type;
+
+        if (tree.branches_num() < 2)
+        {
+            if (!Compile(branch(0), var_names, program, depth))
+            {
+                return false;
+            }
+            program->code.push_back({ Opcode::NEG, 0 });
+            return true;
+        }
+
+        if (!Compile(branch(0), var_names, program, depth))
+        {
+            return false;
+        }
+
+        Polynomial exponent;
+        if ((type == OperationType::POW) && Polynomial::FromAST(branch(1), {}, &exponent))
+        {
+            auto k = exponent.coefficient({});
+            if ((k.imag() == 0.0) && (k.real() >= 1.0) && (k.real() <= POLYNOMIAL_MAX_POWER) && (std::floor(k.real()) == k.real()))
+            {
+                program->code.push_back({ Opcode::POWI, static_cast<size_t>(k.real()) });
+                return true;
+            }
+        }
+
+        if (!Compile(branch(1), var_names, program, depth + 1))
+        {
+            return false;
+        }
+
+        switch (type)
+        {
+        case OperationType::ADD: program->code.push_back({ Opcode::ADD, 0 }); break;
+        case OperationType::SUB: program->code.push_back({ Opcode::SUB, 0 }); break;
+        case OperationType::MUL: program->code.push_back({ Opcode::MUL, 0 }); break;
+        case OperationType::DIV: program->code.push_back({ Opcode::DIV, 0 }); break;
+        case OperationType::POW: program->code.push_back({ Opcode::POW, 0 }); break;
+        default: return false;
+        }
+        return true;
+    }
+    }
+    return false;
+}
+
+template <typename T>
+std::complex<T> Formula::Execute(const Program& program, const std::complex<T>* vars)
+{
+    std::complex<T> stack[FORMULA_MAX_STACK];
+    size_t top = 0;
+
+    for (const auto& instruction : program.code)
+    {
+        switch (instruction.op)
+        {
+        case Opcode::VARIABLE: stack[top++] = vars[instruction.arg]; break;
+        case Opcode::NUMBER:   stack[top++] = std::complex<T>(program.numbers[instruction.arg]); break;
+        case Opcode::ADD:      --top; stack[top - 1] += stack[top]; break;
+        case Opcode::SUB:      --top; stack[top - 1] -= stack[top]; break;
+        case Opcode::MUL:      --top; stack[top - 1] *= stack[top]; break;
+        case Opcode::DIV:      --top; stack[top - 1] /= stack[top]; break;
+        case Opcode::POW:      --top; stack[top - 1] = std::exp(stack[top] * std::log(stack[top - 1])); break;
+        case Opcode::NEG:      stack[top - 1] = -stack[top - 1]; break;
+        case Opcode::FUNCTION: stack[top - 1] = CallFunction(instruction.arg, stack[top - 1]); break;
+        case Opcode::POWI:
+        {
+            std::complex<T> base = stack[top - 1];
+            std::complex<T> result = base;
+            for (size_t i = 1; i < instruction.arg; ++i)
+            {
+                result *= base;
+            }
+            stack[top - 1] = result;
+            break;
+        }
+        }
+    }
+
+    return stack[0];
+}
+
+template <typename T>
+std::complex<T> Formula::CallFunction(size_t func_type, const std::complex<T>& a)
+{
+    using FunctionType = ast::FunctionNode<std::complex<float>>::Type;
+
+    static const T PI_2 = static_cast<T>(std::atan(1.0) * 2.0);
+    const std::complex<T> one = T(1);
+
+    switch (static_cast<FunctionType>(func_type))
+    {
+    case FunctionType::ABS:     return std::abs(a);
+    case FunctionType::ARCCOS:  return std::acos(a);
+    case FunctionType::ARCCOSH: return std::acosh(a);
+    case FunctionType::ARCCOT:  return PI_2 - std::atan(a);
+    case FunctionType::ARCCOTH: return std::atanh(one / a);
+    case FunctionType::ARCSIN:  return std::asin(a);
+    case FunctionType::ARCSINH: return std::asinh(a);
+    case FunctionType::ARCTAN:  return std::atan(a);
+    case FunctionType::ARCTANH: return std::atanh(a);
+    case FunctionType::ARG:     return std::arg(a);
+    case FunctionType::COS:     return std::cos(a);
+    case FunctionType::COSH:    return std::cosh(a);
+    case FunctionType::COT:     return one / std::tan(a);
+    case FunctionType::COTH:    return one / std::tanh(a);
+    case FunctionType::EXP:     return std::exp(a);
+    case FunctionType::LOG:     return std::log(a);
+    case FunctionType::LOG10:   return std::log10(a);
+    case FunctionType::SIN:     return std::sin(a);
+    case FunctionType::SINH:    return std::sinh(a);
+    case FunctionType::SQRT:    return std::sqrt(a);
+    case FunctionType::TAN:     return std::tan(a);
+    case FunctionType::TANH:    return std::tanh(a);
+    default: break;
+    }
+    return a;
+}
+
+#endif // RENDER_FORMULA_H
@@ -0,0 +1,38 @@
+#ifndef RENDER_FRAMESYMMETRY_H
+#define RENDER_FRAMESYMMETRY_H
+
+#include "Render/Renderer.h"
+
+constexpr double SYMMETRY_TOLERANCE = 1e-3;
+
+// Part of a frame that mirrors the rest about the real axis or the origin, when the fractal does. Samples there are
+// copied from their mirror images after the other regions are rendered, which needs the sample grid to be symmetric
+// about the axis to within a thousandth of a sample
+class FrameSymmetry
+{
+public:
+    explicit FrameSymmetry(const RenderJob& job);
+
+    bool empty() const;
+    const std::vector<RenderRegion>& regions() const;
+    void fill(SampleData* data) const;
+
+    // Whether the fractal mirrors about the real axis or about the origin, whatever the view, and the sample of a mirrored point
+    bool mirrored() const;
+    bool pointSymmetric() const;
+    SampleData mirror(const SampleData& sample) const;
+
+private:
+    vec2u size_;
+    size_t layout_;
+    int64_t aa_;
+    int64_t mirror_sum_[2] = {};
+    bool point_ = false;
+    bool conjugate_ = false;
+    bool negate_ = false;
+    vec2u copied_position_;
+    vec2u copied_size_;
+    std::vector<RenderRegion> regions_;
+};
+
+#endif // RENDER_FRAMESYMMETRY_H
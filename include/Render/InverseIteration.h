@@ -0,0 +1,36 @@
+#ifndef RENDER_INVERSEITERATION_H
+#define RENDER_INVERSEITERATION_H
+
+#include "Render/Renderer.h"
+
+constexpr uint32_t INVERSE_CELL_HITS = 2;
+constexpr uint32_t INVERSE_GRID_SIZE = 4096;
+constexpr size_t INVERSE_WARMUP = 64;
+constexpr size_t INVERSE_CANCEL_CHECK = 4096;
+
+// Julia set of a z^n + g(c) drawn by the modified inverse iteration method. Preimages of a repelling fixed point are
+// followed depth first through all n branches, and a branch is pruned once its cell has been reached a few times, so
+// the set is covered about evenly at sample resolution instead of piling up where the inverse branches contract.
+// Cells outside the view are counted on a grid over the disk holding the set, which is as fine as the view
+class InverseIteration
+{
+public:
+    explicit InverseIteration(const RenderJob& job);
+
+    // Julia sets of formulas with known inverse branches in views at most INVERSE_GRID_SIZE cells finer than the whole
+    // set, the rest are left to escape time. Pruning on a coarser grid outside the view would cut off the paths into it
+    static bool Supports(const RenderJob& job);
+
+    bool render(const Renderer& renderer, SampleData* data, RenderStats* stats = nullptr) const;
+
+private:
+    static double Radius(const RenderJob& job);
+    static double GridSize(const RenderJob& job, double radius);
+
+    RenderJob job_;
+    vec2u bins_;
+    double radius_ = 0.0;
+    uint32_t grid_size_ = 0;
+};
+
+#endif // RENDER_INVERSEITERATION_H
@@ -0,0 +1,33 @@
+#ifndef RENDER_ITERATIONTUNER_H
+#define RENDER_ITERATIONTUNER_H
+
+#include "Render/Renderer.h"
+
+constexpr size_t ESCAPE_HISTOGRAM_BINS = 32;
+constexpr size_t MIN_AUTO_ITERATION = 32;
+constexpr size_t MAX_AUTO_ITERATION = 1 << 20;
+constexpr size_t MAX_BLIND_RAISES = 4;
+
+struct EscapeHistogram final
+{
+    size_t bins[ESCAPE_HISTOGRAM_BINS] = {};
+    size_t interior = 0;
+    size_t samples = 0;
+    size_t itrn_max = 0;
+
+    EscapeHistogram() = default;
+    EscapeHistogram(const SampleData* data, size_t count, size_t itrn_max);
+};
+
+class IterationTuner
+{
+public:
+    IterationTuner() = default;
+
+    size_t tune(const EscapeHistogram& histogram);
+
+private:
+    size_t blind_raises_ = 0;
+};
+
+#endif // RENDER_ITERATIONTUNER_H
@@ -0,0 +1,35 @@
+#ifndef RENDER_JULIAATLAS_H
+#define RENDER_JULIAATLAS_H
+
+#include "Render/Renderer.h"
+
+#include <string>
+
+constexpr uint32_t ATLAS_TILE_SIZE = 96;
+constexpr double ATLAS_RADIUS = 2.0;
+
+// Grid of small Julia sets over the view of a job, each tile with the point at its center taken for c. Tiles go whole
+// to the threads, every thread renders them one after another on a single threaded renderer of its own and changes
+// only the point and the size of its copy of the job, so the formula is compiled once for the whole atlas
+class JuliaAtlas
+{
+public:
+    explicit JuliaAtlas(const RenderJob& job, uint32_t tile_size = ATLAS_TILE_SIZE);
+
+    vec2u tiles() const;
+
+    // Column and row of the tile covering a pixel, and the point its Julia set is drawn for
+    vec2u tileAt(const vec2u& pixel) const;
+    vec2f juliaPoint(const vec2u& tile) const;
+
+    bool render(const Renderer& renderer, uint8_t* pixels, RenderStats* stats = nullptr) const;
+    bool save(const Renderer& renderer, const std::string& filename, RenderStats* stats = nullptr) const;
+
+private:
+    vec2u tilePosition(uint32_t col, uint32_t row) const;
+
+    RenderJob job_;
+    vec2u tiles_;
+};
+
+#endif // RENDER_JULIAATLAS_H
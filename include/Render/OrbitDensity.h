@@ -0,0 +1,44 @@
+#ifndef RENDER_ORBITDENSITY_H
+#define RENDER_ORBITDENSITY_H
+
+#include "Render/Renderer.h"
+
+constexpr double DENSITY_SAMPLES_PER_PIXEL = 8.0;
+constexpr double DENSITY_REFERENCE_AREA = 9.0;
+constexpr double DENSITY_MAX_OVERSAMPLING = 16.0;
+constexpr double DENSITY_SAMPLE_RADIUS = 4.0;
+constexpr uint32_t DENSITY_PROBE_SIZE = 512;
+constexpr size_t DENSITY_BATCH_SIZE = 4096;
+constexpr size_t DENSITY_MAX_BINS = size_t(1) << 22;
+constexpr size_t DENSITY_MEMORY_BUDGET = size_t(512) << 20;
+constexpr float DENSITY_EXPOSURE = 0.02F;
+
+// Density of the orbits of escaping starting points over the view, the Buddhabrot of the formula. Starting points are
+// drawn with a probability following the escape time on a coarse probe of the plane, so most of them land near the
+// boundary of the set, and every thread counts orbit points into a histogram of its own that is merged at the end.
+// Samples get the density of orbits of three escape time ranges, each one relative to uniformly spread orbit points.
+// Bins split pixels as far as antialiasing asks within DENSITY_MAX_BINS, and only as many threads count as there are
+// histograms within the memory budget
+class OrbitDensity
+{
+public:
+    explicit OrbitDensity(const RenderJob& job);
+
+    size_t samples() const;
+    bool render(const Renderer& renderer, SampleData* data, RenderStats* stats = nullptr);
+
+private:
+    void probe(const Renderer& renderer);
+
+    template <typename T, typename Step>
+    void accumulate(const Step& step, size_t batch, std::vector<std::complex<T>>* orbit, float* histogram) const;
+
+    RenderJob job_;
+    uint32_t bin_aa_ = 1;
+    vec2u bins_;
+    size_t samples_;
+    size_t band_itrn_[2] = {};
+    std::vector<double> cell_cdf_;
+};
+
+#endif // RENDER_ORBITDENSITY_H
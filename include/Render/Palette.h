@@ -0,0 +1,50 @@
+#ifndef RENDER_PALETTE_H
+#define RENDER_PALETTE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Two periods of the original escape colors, x = itrn * 4 / 255 repeats every 382.5 iterations
+constexpr size_t PALETTE_SIZE = 765;
+
+enum Palettes
+{
+    RAINBOW_PALETTE,
+    FIRE_PALETTE,
+    OCEAN_PALETTE,
+    GRAYSCALE_PALETTE,
+};
+
+struct Color final
+{
+    float r = 0.0F;
+    float g = 0.0F;
+    float b = 0.0F;
+
+    Color& operator += (const Color& color)
+    {
+        r += color.r;
+        g += color.g;
+        b += color.b;
+        return *this;
+    }
+};
+
+class Palette
+{
+public:
+    explicit Palette(size_t type = RAINBOW_PALETTE);
+
+    const Color& operator[](size_t itrn) const;
+    size_t type() const;
+    std::vector<uint8_t> toRGBA() const;
+
+private:
+    size_t type_;
+    std::vector<Color> colors_;
+};
+
+uint8_t ToByte(float channel);
+
+#endif // RENDER_PALETTE_H
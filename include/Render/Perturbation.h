@@ -0,0 +1,49 @@
+#ifndef RENDER_PERTURBATION_H
+#define RENDER_PERTURBATION_H
+
+#include "DoubleDouble.h"
+
+#include <complex>
+#include <vector>
+
+class ReferenceOrbit
+{
+public:
+    ReferenceOrbit() = default;
+    ReferenceOrbit(const vec2dd& c, size_t itrn_max, double limit);
+
+    const vec2dd& center() const;
+    size_t size() const;
+    const std::complex<double>& operator[](size_t n) const;
+
+private:
+    vec2dd center_;
+    std::vector<std::complex<double>> orbit_;
+};
+
+class Perturbation
+{
+public:
+    Perturbation(const vec2dd& center, size_t itrn_max, double limit, double dc_max);
+
+    size_t iterate(const std::complex<double>& dc) const;
+
+    const ReferenceOrbit& reference() const;
+
+private:
+    struct Approximation final
+    {
+        std::complex<double> a;
+        std::complex<double> b;
+        double r;
+    };
+
+    const Approximation* lookup(size_t m, double dz_norm, size_t max_steps, size_t* steps) const;
+
+    ReferenceOrbit reference_;
+    std::vector<std::vector<Approximation>> levels_;
+    size_t itrn_max_;
+    double limit_;
+};
+
+#endif // RENDER_PERTURBATION_H
@@ -0,0 +1,28 @@
+#ifndef RENDER_PNGSTREAM_H
+#define RENDER_PNGSTREAM_H
+
+#include <cstdint>
+#include <fstream>
+#include <string>
+
+// RGB PNG written row by row, deflate runs in stored mode so no row is kept after it is written
+class PngStream
+{
+public:
+    PngStream(const std::string& filename, uint32_t width, uint32_t height);
+
+    bool good() const;
+    void writeRows(const uint8_t* rgb, uint32_t rows);
+
+private:
+    void writeChunk(const char* type, const std::string& data);
+
+    std::ofstream file_;
+    uint32_t width_;
+    uint32_t height_;
+    uint32_t rows_written_ = 0;
+    uint32_t adler_a_ = 1;
+    uint32_t adler_b_ = 0;
+};
+
+#endif // RENDER_PNGSTREAM_H
@@ -0,0 +1,134 @@
+#ifndef RENDER_POLYNOMIAL_H
+#define RENDER_POLYNOMIAL_H
+
+#include "AST.h"
+
+#include <complex>
+#include <map>
+#include <string>
+#include <vector>
+
+class Polynomial
+{
+public:
+    using Monomial = std::vector<unsigned>;
+    using Coefficient = std::complex<double>;
+
+    Polynomial() = default;
+    explicit Polynomial(size_t vars_num);
+    Polynomial(size_t vars_num, const Coefficient& number);
+
+    static Polynomial Variable(size_t vars_num, size_t var_ind);
+
+    template <typename T>
+    static bool FromAST(const ast::AST<T>& tree, const std::vector<std::string>& var_names, Polynomial* poly);
+
+    Polynomial operator + (const Polynomial& p) const;
+    Polynomial operator - (const Polynomial& p) const;
+    Polynomial operator * (const Polynomial& p) const;
+    Polynomial operator * (const Coefficient& k) const;
+    Polynomial operator - () const;
+    Polynomial pow(unsigned power) const;
+
+    bool isConstant() const;
+    bool isApprox(const Polynomial& p, double tolerance = 1e-6) const;
+
+    Coefficient coefficient(const Monomial& monomial) const;
+    unsigned degree(size_t var_ind) const;
+    size_t vars_num() const;
+    const std::map<Monomial, Coefficient>& terms() const;
+
+private:
+    void add(const Monomial& monomial, const Coefficient& k);
+
+    size_t vars_num_ = 0;
+    std::map<Monomial, Coefficient> terms_;
+};
+
+constexpr unsigned POLYNOMIAL_MAX_POWER = 64;
+
+template <typename T>
+bool Polynomial::FromAST(const ast::AST<T>& tree, const std::vector<std::string>& var_names, Polynomial* poly)
+{
+    using NodeType = typename ast::ASTNode<T>::Type;
+    using OperationType = typename ast::OperationNode<T>::Type;
+
+    const size_t vars_num = var_names.size();
+    auto branch = [&tree](size_t ind) { return *static_cast<const ast::AST<T>*>(&tree[ind]); };
+
+    switch (tree.value().get()->NodeType())
+    {
+    case NodeType::NUMBER:
+    {
+        *poly = Polynomial(vars_num, Coefficient(static_cast<ast::NumberNode<T>*>(tree.value().get())->number));
+        return true;
+    }
+    case NodeType::VARIABLE:
+    {
+        const auto& name = static_cast<ast::VariableNode<T>*>(tree.value().get())->name;
+        for (size_t i = 0; i < vars_num; ++i)
+        {
+            if (var_names[i] == name)
+            {
+                *poly = Variable(vars_num, i);
+                return true;
+            }
+        }
+        return false;
+    }
+    case NodeType::OPERATION:
+    {
+        auto type = static_cast<ast::OperationNode<T>*>(tree.value().get())->type;
+
+        Polynomial left;
+        if (!FromAST(branch(0), var_names, &left))
+        {
+            return false;
+        }
+
+        if (tree.branches_num() < 2)
+        {
+            *poly = -left;
+            return type == OperationType::SUB;
+        }
+
+        Polynomial right;
+        if (!FromAST(branch(1), var_names, &right))
+        {
+            return false;
+        }
+
+        switch (type)
+        {
+        case OperationType::ADD: *poly = left + right; return true;
+        case OperationType::SUB: *poly = left - right; return true;
+        case OperationType::MUL: *poly = left * right; return true;
+        case OperationType::DIV:
+        {
+            Coefficient k = right.coefficient(Monomial(vars_num, 0));
+            if (!right.isConstant() || (k == Coefficient()))
+            {
+                return false;
+            }
+            *poly = left * (Coefficient(1.0) / k);
+            return true;
+        }
+        case OperationType::POW:
+        {
+            Coefficient k = right.coefficient(Monomial(vars_num, 0));
+            if (!right.isConstant() || (k.imag() != 0.0) || (k.real() < 0.0) ||
+                (k.real() > POLYNOMIAL_MAX_POWER) || (std::floor(k.real()) != k.real()))
+            {
+                return false;
+            }
+            *poly = left.pow(static_cast<unsigned>(k.real()));
+            return true;
+        }
+        default: return false;
+        }
+    }
+    default: return false;
+    }
+}
+
+#endif // RENDER_POLYNOMIAL_H
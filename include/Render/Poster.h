@@ -0,0 +1,25 @@
+#ifndef RENDER_POSTER_H
+#define RENDER_POSTER_H
+
+#include "Render/Renderer.h"
+
+#include <functional>
+#include <string>
+
+constexpr uint32_t POSTER_BAND_ROWS = 128;
+constexpr uint32_t POSTER_TILE_COLUMNS = 1024;
+
+// Image of any size rendered band by band, each band is encoded to the file as soon as it is done
+class Poster
+{
+public:
+    explicit Poster(const RenderJob& job);
+
+    bool save(const Renderer& renderer, const std::string& filename, const std::function<void(double)>& progress = {},
+              RenderStats* stats = nullptr) const;
+
+private:
+    RenderJob job_;
+};
+
+#endif // RENDER_POSTER_H
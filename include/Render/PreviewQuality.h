@@ -0,0 +1,32 @@
+#ifndef RENDER_PREVIEWQUALITY_H
+#define RENDER_PREVIEWQUALITY_H
+
+#include "Render/Renderer.h"
+
+constexpr double PREVIEW_FRAME_TIME = 1.0 / 30.0;
+constexpr double PREVIEW_SETTLE_TIME = 0.15;
+constexpr double MAX_PREVIEW_SCALE = 8.0;
+constexpr double MIN_PREVIEW_ITERATION_RATIO = 0.25;
+constexpr size_t MIN_PREVIEW_ITERATION = 32;
+
+// Resolution and iteration limit of renders shown while the view is being dragged,
+// adjusted after every render so that one takes about the frame time
+class PreviewQuality
+{
+public:
+    explicit PreviewQuality(double frame_time = PREVIEW_FRAME_TIME);
+
+    RenderJob previewJob(const RenderJob& job) const;
+    void update(double render_time);
+
+    double scale() const;
+    double iterationRatio() const;
+
+    static void Upscale(const uint8_t* pixels, const vec2u& size, uint8_t* upscaled, const vec2u& upscaled_size);
+
+private:
+    double frame_time_;
+    double cost_ = 0.25;
+};
+
+#endif // RENDER_PREVIEWQUALITY_H
@@ -0,0 +1,60 @@
+#ifndef RENDER_RENDERPIPELINE_H
+#define RENDER_RENDERPIPELINE_H
+
+#include "Render/Renderer.h"
+#include "Render/SamplePyramid.h"
+
+#include <condition_variable>
+#include <mutex>
+
+struct RenderResult final
+{
+    uint64_t generation = 0;
+    RenderJob job;
+    std::vector<uint8_t> pixels;
+    RenderStats stats;
+    CacheStats cache_stats;
+    bool caching = false;
+    bool complete = false;
+};
+
+// Renders on a thread of its own. Every submitted job gets the next generation and cancels the one in progress,
+// which stops at the next row of its tiles, results of older generations are never handed out.
+class RenderPipeline
+{
+public:
+    explicit RenderPipeline(size_t threads_num = std::thread::hardware_concurrency());
+    ~RenderPipeline();
+
+    RenderPipeline(const RenderPipeline&) = delete;
+    RenderPipeline& operator = (const RenderPipeline&) = delete;
+
+    uint64_t submit(const RenderJob& job);
+    void cancel();
+    bool poll(RenderResult* result);
+    bool busy() const;
+
+private:
+    void run();
+    void renderJob(const RenderJob& job, uint64_t generation);
+    void publish(const RenderResult& result);
+
+    Renderer renderer_;
+    SamplePyramid pyramid_;
+    std::vector<SampleData> samples_;
+    RenderJob rendered_job_;
+
+    mutable std::mutex mutex_;
+    std::condition_variable condition_;
+    RenderJob pending_job_;
+    RenderResult result_;
+    uint64_t generation_ = 0;
+    bool pending_ = false;
+    bool rendering_ = false;
+    bool has_result_ = false;
+    bool stop_ = false;
+    std::atomic<bool> cancel_ = false;
+    std::thread thread_;
+};
+
+#endif // RENDER_RENDERPIPELINE_H
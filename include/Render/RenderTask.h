@@ -0,0 +1,32 @@
+#ifndef RENDER_RENDERTASK_H
+#define RENDER_RENDERTASK_H
+
+#include "Render/Renderer.h"
+
+#include <string>
+
+// Render job with the formula kept as text, so that it can be written out and read back by another process
+struct RenderTask final
+{
+    size_t input_mode = Z_INPUT;
+    std::string expression_z = "z^2+c";
+    std::string expression_x = "x*x-y*y+cx";
+    std::string expression_y = "2*x*y+cy";
+    RenderJob job;
+    vec2u tile_size = vec2u(256, 256);
+
+    // Set by Parse when the text has a borders key, otherwise the view is left to the caller
+    bool has_borders = false;
+
+    bool compile();
+
+    size_t tilesX() const;
+    size_t tilesY() const;
+    vec2u tilePosition(size_t tile) const;
+    RenderJob tileJob(size_t tile) const;
+
+    std::string serialize() const;
+    static bool Parse(const std::string& text, RenderTask* task);
+};
+
+#endif // RENDER_RENDERTASK_H
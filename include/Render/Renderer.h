@@ -0,0 +1,136 @@
+#ifndef RENDER_RENDERER_H
+#define RENDER_RENDERER_H
+
+#include "Application/Base2D.h"
+#include "Render/CostModel.h"
+#include "Render/Formula.h"
+#include "Render/Palette.h"
+#include "Render/Perturbation.h"
+#include "Render/SampleLayout.h"
+
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+constexpr float TRACE_FREQUENCY = 5.0F;
+constexpr float DISTANCE_WIDTH = 2.0F;
+constexpr float NEWTON_TOLERANCE = 1e-4F;
+constexpr float NEWTON_FADE = 0.9F;
+
+enum FractalModes
+{
+    MAIN,
+    JULIA,
+};
+
+enum RenderModes
+{
+    DEFAULT,
+    TRACER,
+    COMPLEX_DOMAIN,
+    KALI,
+    ORBIT_DENSITY,
+    DISTANCE,
+    NEWTON,
+    INVERSE_ITERATION,
+};
+
+struct RenderJob final
+{
+    Formula formula;
+    size_t fractal_mode = MAIN;
+    size_t rendering_mode = DEFAULT;
+    size_t antialiasing = 0;
+    bool adaptive_antialiasing = false;
+    size_t itrn_max = 0;
+    float limit = 0.0F;
+    float frequency = 0.0F;
+    vec2f julia_point;
+    Borders2D<DoubleDouble> borders;
+    vec2u size;
+    size_t precision = SINGLE_PRECISION;
+    bool deep_zoom = false;
+    size_t palette = RAINBOW_PALETTE;
+    float trace_frequency = TRACE_FREQUENCY;
+    size_t layout = LINEAR_LAYOUT;
+};
+
+// Raw result of one sample, colored afterwards without iterating again
+struct SampleData final
+{
+    uint32_t itrn = 0;
+    std::complex<float> z;
+    float sum[3] = {};
+};
+
+struct RenderRegion final
+{
+    vec2u position;
+    vec2u size;
+    vec2u step = vec2u(1, 1);
+};
+
+struct RenderStats final
+{
+    size_t pixels = 0;
+    size_t promoted = 0;
+    size_t refined = 0;
+    double time = 0.0;
+    double tail = 0.0;
+};
+
+class Renderer
+{
+public:
+    explicit Renderer(size_t threads_num = std::thread::hardware_concurrency());
+
+    void render(const RenderJob& job, uint8_t* pixels, RenderStats* stats = nullptr) const;
+    void render(const RenderJob& job, SampleData* data, RenderStats* stats = nullptr) const;
+    void render(const RenderJob& job, const std::vector<RenderRegion>& regions, SampleData* data, RenderStats* stats = nullptr) const;
+    void render(const RenderJob& job, const std::complex<double>* points, SampleData* data) const;
+    // Points given as offsets from a center, deep zoom jobs iterate them as perturbations of the center's orbit
+    void render(const RenderJob& job, const vec2dd& center, const std::complex<double>* offsets, SampleData* data) const;
+    void renderIncremental(const RenderJob& previous, const RenderJob& job, SampleData* data, RenderStats* stats = nullptr) const;
+
+    // Carries the unescaped samples of data, rendered for the same view up to another iteration limit, on to the one of the job
+    void resume(const RenderJob& job, SampleData* data, RenderStats* stats = nullptr) const;
+
+    static Color Shade(const RenderJob& job, const Palette& palette, const SampleData& sample);
+    static void Colorize(const RenderJob& job, const SampleData* data, uint8_t* pixels);
+    static size_t SamplesNum(const RenderJob& job);
+
+    // Renders stop at the next row once the flag is set, leaving the rest of the data unwritten
+    void setCancelFlag(const std::atomic<bool>* cancel);
+    bool cancelled() const;
+    size_t threadsNum() const;
+
+    // Rows are ordered and split by the cost measured on the recent renders of the fractal, or taken in order without it
+    void setCostPrediction(bool enabled);
+
+    static bool IsDeepZoom(const RenderJob& job);
+    static bool SameFractal(const RenderJob& job1, const RenderJob& job2);
+
+    // Escape times in single precision keep their whole state in the samples, the iteration limit may change under them
+    static bool Resumable(const RenderJob& previous, const RenderJob& job);
+    static size_t Fingerprint(const RenderJob& job);
+    static RenderJob SubJob(const RenderJob& job, const vec2u& position, const vec2u& size);
+    static bool PanOffset(const RenderJob& previous, const RenderJob& job, vec2i* offset);
+
+private:
+    void renderFrame(const RenderJob& job, SampleData* data, RenderStats* stats, bool resume) const;
+    void renderRegions(const RenderJob& job, const std::vector<RenderRegion>& regions, SampleData* data, RenderStats* stats, bool resume) const;
+
+    template <typename Function>
+    void forEachRow(const RenderJob& job, const std::vector<RenderRegion>& regions, const Function& function, RenderStats* stats,
+                    bool modeled) const;
+    std::vector<RowSpan> scheduleSpans(const RenderJob& job, std::vector<RowSpan> spans) const;
+
+    size_t threads_num_;
+    const std::atomic<bool>* cancel_ = nullptr;
+    bool cost_prediction_ = true;
+    mutable CostModel cost_model_;
+    mutable std::mutex cost_mutex_;
+};
+
+#endif // RENDER_RENDERER_H
@@ -0,0 +1,60 @@
+#ifndef RENDER_SAMPLELAYOUT_H
+#define RENDER_SAMPLELAYOUT_H
+
+#include "vec2.h"
+
+#include <cstddef>
+#include <cstdint>
+
+constexpr uint32_t LAYOUT_TILE_SIZE = 8;
+
+enum SampleLayouts
+{
+    LINEAR_LAYOUT,
+    TILED_LAYOUT,
+};
+
+// Order of the pixels of a frame in memory. Tiled frames are stored as rows of 8x8 tiles with pixels in Z-order inside,
+// so that neighbours in both directions share cache lines and pages, the frame is padded to whole tiles.
+class SampleLayout
+{
+public:
+    SampleLayout(const vec2u& size, size_t layout) :
+        size_(size), layout_(layout), tiles_x_((size.x + LAYOUT_TILE_SIZE - 1) / LAYOUT_TILE_SIZE)
+    {}
+
+    size_t pixels() const
+    {
+        if (layout_ == LINEAR_LAYOUT)
+        {
+            return static_cast<size_t>(size_.x) * size_.y;
+        }
+        return static_cast<size_t>(tiles_x_) * ((size_.y + LAYOUT_TILE_SIZE - 1) / LAYOUT_TILE_SIZE) * LAYOUT_TILE_SIZE * LAYOUT_TILE_SIZE;
+    }
+
+    size_t operator()(uint32_t col, uint32_t row) const
+    {
+        if (layout_ == LINEAR_LAYOUT)
+        {
+            return static_cast<size_t>(row) * size_.x + col;
+        }
+
+        const size_t tile = static_cast<size_t>(row / LAYOUT_TILE_SIZE) * tiles_x_ + col / LAYOUT_TILE_SIZE;
+        return tile * LAYOUT_TILE_SIZE * LAYOUT_TILE_SIZE + Interleave(col % LAYOUT_TILE_SIZE) + 2 * Interleave(row % LAYOUT_TILE_SIZE);
+    }
+
+private:
+    // Spreads the bits of a coordinate inside a tile to the even bits
+    static uint32_t Interleave(uint32_t x)
+    {
+        x = (x | (x << 2)) & 0x33U;
+        x = (x | (x << 1)) & 0x55U;
+        return x;
+    }
+
+    vec2u size_;
+    size_t layout_;
+    uint32_t tiles_x_;
+};
+
+#endif // RENDER_SAMPLELAYOUT_H
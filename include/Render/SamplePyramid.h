@@ -0,0 +1,75 @@
+#ifndef RENDER_SAMPLEPYRAMID_H
+#define RENDER_SAMPLEPYRAMID_H
+
+#include "Render/Renderer.h"
+
+#include <unordered_map>
+
+constexpr uint32_t PYRAMID_TILE_SIZE = 64;
+constexpr int PYRAMID_MAX_LEVEL = 60;
+constexpr size_t PYRAMID_MEMORY_BUDGET = size_t(256) << 20;
+constexpr double PYRAMID_TIME_BUDGET = 0.1;
+
+struct CacheStats final
+{
+    size_t hits = 0;
+    size_t misses = 0;
+    size_t tiles = 0;
+    size_t bytes = 0;
+};
+
+class SamplePyramid
+{
+public:
+    explicit SamplePyramid(size_t memory_budget = PYRAMID_MEMORY_BUDGET);
+
+    bool render(const Renderer& renderer, const RenderJob& job, uint8_t* pixels, RenderStats* stats = nullptr,
+                double time_budget = PYRAMID_TIME_BUDGET);
+    void clear();
+
+    void setMemoryBudget(size_t memory_budget);
+    const CacheStats& cacheStats() const;
+
+    static bool Supports(const RenderJob& job);
+
+private:
+    struct TileKey final
+    {
+        size_t fractal = 0;
+        int level = 0;
+        int64_t x = 0;
+        int64_t y = 0;
+
+        bool operator == (const TileKey& key) const = default;
+    };
+
+    struct TileKeyHash final
+    {
+        size_t operator()(const TileKey& key) const;
+    };
+
+    using Tile = std::vector<SampleData>;
+
+    struct Entry final
+    {
+        Tile tile;
+        uint64_t last_use = 0;
+    };
+
+    const Tile* findTile(const TileKey& key);
+    const Tile* computeTile(const Renderer& renderer, const TileKey& key, RenderStats* stats);
+    void evictTiles();
+
+    static int Level(const RenderJob& job);
+    static const SampleData* Sample(const Tile& tile, const TileKey& key, int64_t i, int64_t j);
+
+    RenderJob job_;
+    size_t fractal_ = 0;
+    std::unordered_map<size_t, RenderJob> fractals_;
+    std::unordered_map<TileKey, Entry, TileKeyHash> tiles_;
+    size_t memory_budget_;
+    uint64_t frame_ = 0;
+    CacheStats cache_stats_;
+};
+
+#endif // RENDER_SAMPLEPYRAMID_H
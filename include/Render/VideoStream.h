@@ -0,0 +1,31 @@
+#ifndef RENDER_VIDEOSTREAM_H
+#define RENDER_VIDEOSTREAM_H
+
+#include <cstdint>
+#include <ostream>
+#include <vector>
+
+enum VideoFormats
+{
+    Y4M_VIDEO,
+    PPM_VIDEO,
+};
+
+// Uncompressed frames written one after another, as YUV4MPEG2 with 4:2:0 chroma or as a sequence of binary PPM images
+class VideoStream
+{
+public:
+    VideoStream(std::ostream& stream, uint32_t width, uint32_t height, size_t fps, size_t format = Y4M_VIDEO);
+
+    bool good() const;
+    void writeFrame(const uint8_t* rgb);
+
+private:
+    std::ostream& stream_;
+    uint32_t width_;
+    uint32_t height_;
+    size_t format_;
+    std::vector<uint8_t> planes_;
+};
+
+#endif // RENDER_VIDEOSTREAM_H
@@ -0,0 +1,47 @@
+#ifndef RENDER_ZOOMANIMATION_H
+#define RENDER_ZOOMANIMATION_H
+
+#include "Render/Renderer.h"
+#include "Render/VideoStream.h"
+
+#include <deque>
+#include <functional>
+
+constexpr uint32_t STRIP_CHUNK_ROWS = 32;
+
+// Zoom into the center of a view. The fractal is rendered once on an exponential map around the center,
+// rows of growing depth, and every frame is resampled from the rows it covers.
+class ZoomAnimation
+{
+public:
+    ZoomAnimation(const RenderJob& job, double zoom, size_t frames_num);
+
+    bool save(const Renderer& renderer, VideoStream* stream, const std::function<void(double)>& progress = {});
+    size_t stripSamples() const;
+
+    // Zoom of the last frame, lower than the requested one when the view gets too deep for double precision
+    double zoom() const;
+
+private:
+    void renderRows(const Renderer& renderer, size_t rows_end);
+    void resampleFrame(double row_offset, uint8_t* rgb) const;
+
+    RenderJob job_;
+    size_t frames_num_;
+    double zoom_;
+
+    uint32_t columns_ = 0;
+    size_t rows_num_ = 0;
+    double step_ = 0.0;
+    double max_radius_ = 0.0;
+
+    std::vector<float> pixel_rows_;
+    std::vector<float> pixel_columns_;
+    float pixel_depth_ = 0.0F;
+
+    std::deque<std::vector<uint8_t>> rows_;
+    size_t first_row_ = 0;
+    size_t strip_samples_ = 0;
+};
+
+#endif // RENDER_ZOOMANIMATION_H
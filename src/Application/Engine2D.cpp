@@ -3,9 +3,11 @@
 
 #include <algorithm>
 #include <cmath>
+#include <iomanip>
 #include <sstream>
 
 constexpr size_t ANTI_ALIASING = 4;
+constexpr int MAX_GRID_LINES = 1000;
 
 Engine2D::Engine2D(const vec2u& size, const char* title) :
     sf::RenderWindow(sf::VideoMode(size.x, size.y), title, sf::Style::Default, sf::ContextSettings(0, 0, ANTI_ALIASING)), Base2D(size),
@@ -44,7 +46,7 @@ bool Engine2D::handleEvent(const sf::Event& event)
     // Zooming
     if (event.type == sf::Event::MouseWheelMoved)
     {
-        WheelZooming(static_cast<float>(event.mouseWheel.delta), Screen2Base(vec(sf::Mouse::getPosition(*this))));
+        WheelZooming(static_cast<float>(event.mouseWheel.delta), vec(sf::Mouse::getPosition(*this)));
         return true;
     }
 
@@ -88,44 +90,65 @@ void Engine2D::drawGrid(const sf::Font& font, unsigned font_size)
 {
     sf::Color color = sf::Color::White;
 
-    vec2f ratio = getRatio();
+    vec2d ratio = getRatio();
     sf::VertexArray grid(sf::Lines);
 
     std::vector<sf::Text> labels;
 
-    float ratio_div = ratio.x / ratio.y;
+    const double ratio_div = ratio.x / ratio.y;
+    const double min_label_pos = ratio_div * 0.01;
 
-    const float min_label_pos = ratio_div * 0.01F;
-    float x = 0.0F;
-    auto makeLabel = [&](const vec2f& label_pos, const vec2f& v1, const vec2f& v2)
+    visitBorders([&]<typename T>(const Borders2D<T>& borders)
     {
-        std::stringstream number_text;
-        if (std::abs(x) > min_label_pos)
+        using std::abs;
+        using std::floor;
+
+        // Enough digits to tell neighbouring lines apart
+        double magnitude = std::max({ std::abs(static_cast<double>(borders.left)), std::abs(static_cast<double>(borders.right)),
+                                      std::abs(static_cast<double>(borders.bottom)), std::abs(static_cast<double>(borders.top)) });
+        int digits = std::clamp(static_cast<int>(std::ceil(std::log10(magnitude / ratio_div))) + 2, 6, 17);
+
+        auto makeLabel = [&](const T& x, const vec2<T>& label_pos, const vec2<T>& v1, const vec2<T>& v2)
         {
-            number_text << x;
-        }
+            std::stringstream number_text;
+            if (abs(x) > T(min_label_pos))
+            {
+                number_text << std::setprecision(digits) << static_cast<double>(x);
+            }
 
-        labels.emplace_back(sf::Text(number_text.str(), font, font_size));
-        labels.back().setFillColor(color);
-        labels.back().setOutlineThickness(0.8F);
-        labels.back().setPosition(vec(getLabelPos(label_pos, vec2f(labels.back().getLocalBounds().width, labels.back().getLocalBounds().height))));
+            labels.emplace_back(sf::Text(number_text.str(), font, font_size));
+            labels.back().setFillColor(color);
+            labels.back().setOutlineThickness(0.8F);
+            labels.back().setPosition(vec(getLabelPos(Base2Screen(label_pos), vec2f(labels.back().getLocalBounds().width, labels.back().getLocalBounds().height))));
 
-        grid.append(sf::Vertex(vec(Base2Screen(v1)), color));
-        grid.append(sf::Vertex(vec(Base2Screen(v2)), color));
-        x += ratio_div;
-    };
+            grid.append(sf::Vertex(vec(Base2Screen(v1)), color));
+            grid.append(sf::Vertex(vec(Base2Screen(v2)), color));
+        };
 
-    x = borders_.bottom - std::fmod(borders_.bottom, ratio_div) + ratio_div * static_cast<float>(borders_.bottom > 0.0F);
-    while (x < borders_.top)
-    {
-        makeLabel(vec2f(0.0F, x), vec2f(borders_.left, x), vec2f(borders_.right, x));
-    }
+        const T step = T(ratio_div);
 
-    x = borders_.left - std::fmod(borders_.left, ratio_div) + ratio_div * static_cast<float>(borders_.left > 0.0F);
-    while (x < borders_.right)
-    {
-        makeLabel(vec2f(x, 0.0F), vec2f(x, borders_.bottom), vec2f(x, borders_.top));
-    }
+        T first = (floor(borders.bottom / step) + T(1.0)) * step;
+        for (int i = 0; i < MAX_GRID_LINES; ++i)
+        {
+            T x = first + step * T(i);
+            if (!(x < borders.top))
+            {
+                break;
+            }
+            makeLabel(x, vec2<T>(T(0.0), x), vec2<T>(borders.left, x), vec2<T>(borders.right, x));
+        }
+
+        first = (floor(borders.left / step) + T(1.0)) * step;
+        for (int i = 0; i < MAX_GRID_LINES; ++i)
+        {
+            T x = first + step * T(i);
+            if (!(x < borders.right))
+            {
+                break;
+            }
+            makeLabel(x, vec2<T>(x, T(0.0)), vec2<T>(x, borders.bottom), vec2<T>(x, borders.top));
+        }
+    });
 
     draw(grid);
 
@@ -156,75 +179,75 @@ void Engine2D::toggleFullScreen()
     }
 }
 
-void Engine2D::WheelZooming(float wheel_delta, const vec2f& point)
+void Engine2D::WheelZooming(float wheel_delta, const vec2i& pixel)
 {
-    float width = borders_.right - borders_.left;
-    float height = borders_.top - borders_.bottom;
-
-    float x_ratio = (point.x - borders_.left) / width;
-    float y_ratio = (point.y - borders_.bottom) / height;
-
-    Borders new_frame = {
-        borders_.left + x_ratio * zooming_ratio_ * width * wheel_delta,
-        borders_.right - (1 - x_ratio) * zooming_ratio_ * width * wheel_delta,
-        borders_.bottom + y_ratio * zooming_ratio_ * height * wheel_delta,
-        borders_.top - (1 - y_ratio) * zooming_ratio_ * height * wheel_delta,
-    };
-
-    borders_ = new_frame;
+    updateBorders([&]<typename T>(const Borders2D<T>& borders)
+    {
+        T width = borders.width();
+        T height = borders.height();
+        T delta = static_cast<T>(zooming_ratio_ * wheel_delta);
+
+        T x_ratio = static_cast<T>(pixel.x) / static_cast<T>(size_.x);
+        T y_ratio = T(1.0) - static_cast<T>(pixel.y) / static_cast<T>(size_.y);
+
+        return Borders2D<T>(
+            borders.left + x_ratio * delta * width,
+            borders.right - (T(1.0) - x_ratio) * delta * width,
+            borders.bottom + y_ratio * delta * height,
+            borders.top - (T(1.0) - y_ratio) * delta * height
+        );
+    });
 }
 
 void Engine2D::MouseMoving(const vec2i& movement)
 {
-    float width = borders_.right - borders_.left;
-    float height = borders_.top - borders_.bottom;
-    vec2f delta = vec2f(movement) / vec(getSize());
-
-    Borders new_frame = {
-        borders_.left - width * delta.x,
-        borders_.right - width * delta.x,
-        borders_.bottom + height * delta.y,
-        borders_.top + height * delta.y,
-    };
-
-    borders_ = new_frame;
+    // Moved by whole pixels of the current view whatever the working precision, samples kept from the previous frame
+    // stay on the grid of the new one instead of drifting by the rounding of every step
+    const DoubleDouble width = borders_.width();
+    const DoubleDouble height = borders_.height();
+    const DoubleDouble shift_x = width * static_cast<double>(movement.x) / static_cast<double>(getSize().x);
+    const DoubleDouble shift_y = height * static_cast<double>(movement.y) / static_cast<double>(getSize().y);
+
+    const DoubleDouble left = borders_.left - shift_x;
+    const DoubleDouble top = borders_.top + shift_y;
+    borders_ = Borders2D<DoubleDouble>(left, left + width, top - height, top);
 }
 
-vec2f Engine2D::getLabelPos(const vec2f& point, const vec2f& text_size) const
+vec2f Engine2D::getLabelPos(const vec2i& pixel, const vec2f& text_size) const
 {
-    return clamp(Base2Screen(point), vec2i(), vec2i(size_ - text_size * vec2f(1.0F, 1.5F)));
+    return clamp(pixel, vec2i(), vec2i(size_ - text_size * vec2f(1.0F, 1.5F)));
 }
 
-vec2f Engine2D::getRatio() const
+vec2d Engine2D::getRatio() const
 {
-    const float initial_ratio = 10.0F;
-    static vec2f ratio(initial_ratio, initial_ratio);
+    const double initial_ratio = 10.0;
+    static vec2d ratio(initial_ratio, initial_ratio);
 
-    float ratio_div = ratio.x / ratio.y;
+    double ratio_div = ratio.x / ratio.y;
 
     auto size = getSize();
-    float screen_square = ratio_div * ratio_div * static_cast<float>(size.x * size.y) /
-        ((borders_.right - borders_.left) * (borders_.top - borders_.bottom));
+    double screen_square = ratio_div * ratio_div * static_cast<double>(size.x * size.y) /
+        (static_cast<double>(borders_.width()) * static_cast<double>(borders_.height()));
 
-    const float max_square = 50000.0F;
-    const float min_square = 8000.0F;
+    const double max_square = 50000.0;
+    const double min_square = 8000.0;
 
-    constexpr float TWO = 2.0F;
-    constexpr float FIVE = 5.0F;
-    constexpr float TEN = 10.0F;
+    constexpr double TWO = 2.0;
+    constexpr double FIVE = 5.0;
+    constexpr double TEN = 10.0;
 
     if (screen_square > max_square)
     {
         switch (static_cast<int>(ratio.y))
         {
         case static_cast<int>(TWO):
-            ratio = vec2f(ratio.x, FIVE);
+            ratio = vec2d(ratio.x, FIVE);
             break;
         case static_cast<int>(FIVE):
-            ratio = vec2f(ratio.x, TEN);
+            ratio = vec2d(ratio.x, TEN);
             break;
         case static_cast<int>(TEN):
-            ratio = vec2f(ratio.x / TEN, TWO);
+            ratio = vec2d(ratio.x / TEN, TWO);
             break;
         }
     }
@@ -233,13 +256,13 @@ vec2f Engine2D::getRatio() const
         switch (static_cast<int>(ratio.y))
         {
         case static_cast<int>(TWO):
-            ratio = vec2f(ratio.x * TEN, TEN);
+            ratio = vec2d(ratio.x * TEN, TEN);
             break;
         case static_cast<int>(FIVE):
-            ratio = vec2f(ratio.x, TWO);
+            ratio = vec2d(ratio.x, TWO);
             break;
         case static_cast<int>(TEN):
-            ratio = vec2f(ratio.x, FIVE);
+            ratio = vec2d(ratio.x, FIVE);
             break;
         }
     }
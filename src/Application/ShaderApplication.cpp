@@ -1,9 +1,21 @@
 #include "Application/ShaderApplication.h"
 
+static const char* IMAGE_SHADER =
+    "#version 130\n"
+    "\n"
+    "uniform sampler2D image;\n"
+    "uniform ivec2     winsizes;\n"
+    "\n"
+    "void main()\n"
+    "{\n"
+    "gl_FragColor = texture2D(image, gl_FragCoord.xy / vec2(winsizes));\n"
+    "}";
+
 ShaderApplication::ShaderApplication(const vec2u& win_size, const char* font_location, float font_size, const char* win_title) :
     Application(win_size, font_location, font_size, win_title)
 {
     setRenderImageSize(win_size);
+    image_shader_.loadFromMemory(IMAGE_SHADER, sf::Shader::Fragment);
 }
 
 void ShaderApplication::setRenderImageSize(const vec2u& size)
@@ -12,6 +24,21 @@ void ShaderApplication::setRenderImageSize(const vec2u& size)
     sprite_ = sf::Sprite(render_texture_.getTexture());
 }
 
+void ShaderApplication::setRenderImage(const sf::Uint8* pixels)
+{
+    sf::Vector2u size = render_texture_.getSize();
+    if ((image_texture_.getSize().x != size.x) || (image_texture_.getSize().y != size.y))
+    {
+        image_texture_.create(size.x, size.y);
+    }
+    image_texture_.update(pixels);
+
+    image_shader_.setUniform("image", image_texture_);
+    image_shader_.setUniform("winsizes", sf::Glsl::Ivec2(sf::Vector2i(size)));
+
+    render_texture_.draw(sprite_, &image_shader_);
+}
+
 sf::Sprite ShaderApplication::getRenderOutput() const
 {
     return sprite_;
@@ -1,7 +1,11 @@
 #include "Puzabrot.h"
+#include "Render/JuliaAtlas.h"
 #include "Utils.h"
 
+#include <SFML/OpenGL.hpp>
 #include <cstring>
+#include <iomanip>
+#include <sstream>
 
 #define COND_RETURN(cond, ret) \
     if (cond)                  \
@@ -17,6 +21,15 @@ constexpr size_t MAX_ITERATION = 500;
 constexpr float GRID_FONT_SIZE = 14.0F;
 constexpr float UI_FONT_SIZE = 16.0F;
 constexpr size_t SCREENSHOT_WIDTH = 7680;
+constexpr uint32_t POSTER_WIDTH = 30720;
+constexpr size_t DEEP_ZOOM_ORBIT_SIZE = 1024;
+constexpr GLint DEEP_ZOOM_RESERVED_UNIFORMS = 64;
+
+#ifndef GL_MAX_FRAGMENT_UNIFORM_COMPONENTS
+#define GL_MAX_FRAGMENT_UNIFORM_COMPONENTS 0x8B49
+#endif
+constexpr size_t MAX_ANTI_ALIASING = 3;
+constexpr uint32_t ITERATION_PROBE_WIDTH = 64;
 
 static const char* TITLE_STRING = "Puzabrot";
 static const char* FONT_LOCATION = "assets/consola.ttf";
@@ -29,6 +42,12 @@ static const vec2f SOUND_BUTTON_POS = { 10.0F, 175.0F };
 static const vec2f ITERATION_BUTTON_POS = { 10.0F, 200.0F };
 static const vec2f PARAMETER_BUTTON_POS = { 10.0F, 225.0F };
 static const vec2f ANTI_ALIASING_BUTTON_POS = { 10.0F, 250.0F };
+static const vec2f BACKEND_BUTTON_POS = { 10.0F, 275.0F };
+static const vec2f DEEP_ZOOM_BUTTON_POS = { 10.0F, 300.0F };
+static const vec2f PRECISION_BUTTON_POS = { 10.0F, 325.0F };
+static const vec2f PALETTE_BUTTON_POS = { 10.0F, 350.0F };
+static const vec2f AUTO_ITERATION_BUTTON_POS = { 10.0F, 375.0F };
+static const vec2f STATS_LABEL_POS = { 10.0F, 400.0F };
 
 #define INPUT_BUTTON static_cast<SwitchButton*>(ui_.getVidget("input_button"))
 #define INPUT_X static_cast<InputBox*>(ui_.getVidget("input_x"))
@@ -40,6 +59,12 @@ static const vec2f ANTI_ALIASING_BUTTON_POS = { 10.0F, 250.0F };
 #define ITERATION_BUTTON static_cast<Button*>(ui_.getVidget("iteration_button"))
 #define PARAMETER_BUTTON static_cast<Button*>(ui_.getVidget("parameter_button"))
 #define ANTI_ALIASING_BUTTON static_cast<SwitchButton*>(ui_.getVidget("antialiasing_button"))
+#define BACKEND_BUTTON static_cast<SwitchButton*>(ui_.getVidget("backend_button"))
+#define DEEP_ZOOM_BUTTON static_cast<Button*>(ui_.getVidget("deep_zoom_button"))
+#define PRECISION_BUTTON static_cast<SwitchButton*>(ui_.getVidget("precision_button"))
+#define PALETTE_BUTTON static_cast<SwitchButton*>(ui_.getVidget("palette_button"))
+#define AUTO_ITERATION_BUTTON static_cast<Button*>(ui_.getVidget("auto_iteration_button"))
+#define STATS_LABEL static_cast<Label*>(ui_.getVidget("stats_label"))
 
 #define SET_INPUT_Y_POS INPUT_Y->setPosition(INPUT_X->getPosition() + vec2f(0.0F, INPUT_X->getSize().y + 3.0F))
 
@@ -56,6 +81,7 @@ Puzabrot::Puzabrot() :
 {
     params_.limit = LIMIT;
     params_.frequency = FREQUENCY;
+    params_.trace_frequency = TRACE_FREQUENCY;
     params_.itrn_max = MAX_ITERATION;
 
     setZoomingRatio(ZOOMING_RATIO);
@@ -85,6 +111,10 @@ Puzabrot::Puzabrot() :
     RENDER_BUTTON->addText("TRACER");
     RENDER_BUTTON->addText("DOMAIN");
     RENDER_BUTTON->addText("KALI");
+    RENDER_BUTTON->addText("DENSITY");
+    RENDER_BUTTON->addText("DISTANCE");
+    RENDER_BUTTON->addText("NEWTON");
+    RENDER_BUTTON->addText("INVERSE");
 
     ui_.addVidget("grid_button", new Button(getFont(), UI_FONT_SIZE, GRID_BUTTON_POS));
     GRID_BUTTON->setText("GRID");
@@ -100,6 +130,33 @@ Puzabrot::Puzabrot() :
     ANTI_ALIASING_BUTTON->addText("ANTI ALIASING x4");
     ANTI_ALIASING_BUTTON->addText("ANTI ALIASING x9");
     ANTI_ALIASING_BUTTON->addText("ANTI ALIASING x16");
+    ANTI_ALIASING_BUTTON->addText("ADAPTIVE ANTI ALIASING x16");
+
+    ui_.addVidget("backend_button", new SwitchButton(getFont(), UI_FONT_SIZE, BACKEND_BUTTON_POS));
+    BACKEND_BUTTON->addText("GPU");
+    BACKEND_BUTTON->addText("CPU");
+
+    ui_.addVidget("deep_zoom_button", new Button(getFont(), UI_FONT_SIZE, DEEP_ZOOM_BUTTON_POS));
+    DEEP_ZOOM_BUTTON->setText("DEEP ZOOM");
+
+    ui_.addVidget("precision_button", new SwitchButton(getFont(), UI_FONT_SIZE, PRECISION_BUTTON_POS));
+    PRECISION_BUTTON->addText("FLOAT");
+    PRECISION_BUTTON->addText("DOUBLE");
+    PRECISION_BUTTON->addText("DOUBLE-DOUBLE");
+
+    ui_.addVidget("palette_button", new SwitchButton(getFont(), UI_FONT_SIZE, PALETTE_BUTTON_POS));
+    PALETTE_BUTTON->addText("RAINBOW");
+    PALETTE_BUTTON->addText("FIRE");
+    PALETTE_BUTTON->addText("OCEAN");
+    PALETTE_BUTTON->addText("GRAYSCALE");
+
+    ui_.addVidget("auto_iteration_button", new Button(getFont(), UI_FONT_SIZE, AUTO_ITERATION_BUTTON_POS));
+    AUTO_ITERATION_BUTTON->setText("AUTO ITERATION");
+
+    ui_.addVidget("stats_label", new Label(getFont(), UI_FONT_SIZE, STATS_LABEL_POS));
+    STATS_LABEL->hide();
+
+    updatePalette();
 }
 
 void Puzabrot::prerun()
@@ -202,13 +259,53 @@ void Puzabrot::handleAppEvent(const sf::Event& event)
             synth_->pause();
         }
 
-        // Toggle antialiasing level
-        if (options_.antialiasing != ANTI_ALIASING_BUTTON->value())
+        // Toggle antialiasing level, the adaptive one supersamples only the edges on CPU
+        size_t antialiasing = std::min(ANTI_ALIASING_BUTTON->value(), MAX_ANTI_ALIASING);
+        bool adaptive_antialiasing = ANTI_ALIASING_BUTTON->value() > MAX_ANTI_ALIASING;
+        if ((options_.antialiasing != antialiasing) || (options_.adaptive_antialiasing != adaptive_antialiasing))
         {
-            options_.antialiasing = ANTI_ALIASING_BUTTON->value();
+            options_.antialiasing = antialiasing;
+            options_.adaptive_antialiasing = adaptive_antialiasing;
             makeShader();
             render();
         }
+
+        // Toggle render backend
+        if (options_.backend != BACKEND_BUTTON->value())
+        {
+            options_.backend = BACKEND_BUTTON->value();
+            render();
+        }
+
+        // Toggle deep zoom
+        if (options_.deep_zoom != DEEP_ZOOM_BUTTON->pressed())
+        {
+            options_.deep_zoom = DEEP_ZOOM_BUTTON->pressed();
+            makeShader();
+            render();
+        }
+
+        // Change coordinates precision
+        if (getPrecision() != PRECISION_BUTTON->value())
+        {
+            setPrecision(PRECISION_BUTTON->value());
+            render();
+        }
+
+        // Change palette, only recoloring the stored samples
+        if (options_.palette != PALETTE_BUTTON->value())
+        {
+            options_.palette = PALETTE_BUTTON->value();
+            updatePalette();
+            render();
+        }
+
+        // Toggle iteration limit tuning
+        if (options_.auto_iteration != AUTO_ITERATION_BUTTON->pressed())
+        {
+            options_.auto_iteration = AUTO_ITERATION_BUTTON->pressed();
+            render();
+        }
     }
 
     // Toggle UI showing
@@ -223,6 +320,7 @@ void Puzabrot::handleAppEvent(const sf::Event& event)
         options_.fractal_mode = MAIN;
         params_.limit = LIMIT;
         params_.frequency = FREQUENCY;
+        params_.trace_frequency = TRACE_FREQUENCY;
         params_.itrn_max = MAX_ITERATION;
         setBorders(-UPPER_BORDER, UPPER_BORDER, 0.5F);
         makeShader();
@@ -235,6 +333,34 @@ void Puzabrot::handleAppEvent(const sf::Event& event)
         savePicture();
     }
 
+    // Export a poster
+    else if ((event.type == sf::Event::KeyPressed) && (event.key.code == sf::Keyboard::P) && !TEXT_ENTERING)
+    {
+        static int poster_num = 0;
+        savePoster("poster(" + std::to_string(poster_num++) + ").png",
+                   vec2u(POSTER_WIDTH, static_cast<uint32_t>(static_cast<float>(POSTER_WIDTH) / static_cast<float>(getSize().x) * static_cast<float>(getSize().y))));
+    }
+
+    // Julia sets of the points of the view side by side
+    else if ((event.type == sf::Event::KeyPressed) && (event.key.code == sf::Keyboard::A) && !TEXT_ENTERING && (options_.fractal_mode == MAIN))
+    {
+        options_.showing_atlas = !options_.showing_atlas;
+        render();
+    }
+
+    // Julia set of the clicked atlas tile
+    else if ((event.type == sf::Event::MouseButtonPressed) && (event.mouseButton.button == sf::Mouse::Left) && options_.showing_atlas &&
+             (options_.fractal_mode == MAIN))
+    {
+        JuliaAtlas atlas(makeRenderJob(vec2u(render_texture_.getSize().x, render_texture_.getSize().y)));
+        params_.julia_point = atlas.juliaPoint(atlas.tileAt(vec2u(static_cast<uint32_t>(std::max(event.mouseButton.x, 0)),
+                                                                  static_cast<uint32_t>(std::max(event.mouseButton.y, 0)))));
+        options_.showing_atlas = false;
+        options_.fractal_mode = JULIA;
+        makeShader();
+        render();
+    }
+
     // Julia set drawing
     else if ((event.type == sf::Event::KeyPressed) && (event.key.code == sf::Keyboard::Tab) && !TEXT_ENTERING)
     {
@@ -243,12 +369,17 @@ void Puzabrot::handleAppEvent(const sf::Event& event)
             options_.julia_dragging = true;
             options_.fractal_mode = JULIA;
             makeShader();
+            renderPreview();
         }
         else
         {
             if (options_.julia_dragging)
             {
                 options_.julia_dragging = false;
+                if (previewing_)
+                {
+                    render();
+                }
             }
             else
             {
@@ -275,11 +406,21 @@ void Puzabrot::handleAppEvent(const sf::Event& event)
         {
         case DEFAULT:
         case TRACER:
+        case DISTANCE:
         {
-            params_.limit *= std::pow(2.0F, static_cast<float>(event.mouseWheel.delta));
+            if ((options_.rendering_mode == TRACER) && sf::Keyboard::isKeyPressed(sf::Keyboard::LShift))
+            {
+                params_.trace_frequency *= std::pow(1.05F, static_cast<float>(event.mouseWheel.delta));
+            }
+            else
+            {
+                params_.limit *= std::pow(2.0F, static_cast<float>(event.mouseWheel.delta));
+            }
             break;
         }
         case COMPLEX_DOMAIN:
+        case NEWTON:
+        case INVERSE_ITERATION:
         {
             break;
         }
@@ -288,6 +429,11 @@ void Puzabrot::handleAppEvent(const sf::Event& event)
             params_.frequency *= std::pow(1.005F, static_cast<float>(event.mouseWheel.delta));
             break;
         }
+        case ORBIT_DENSITY:
+        {
+            params_.frequency *= std::pow(1.05F, static_cast<float>(event.mouseWheel.delta));
+            break;
+        }
         }
         render();
     }
@@ -331,9 +477,23 @@ void Puzabrot::activity()
 {
     clear();
 
-    if (options_.julia_dragging)
+    RenderResult result;
+    if (pipeline_.poll(&result))
+    {
+        showResult(result);
+    }
+
+    // While the Julia point follows the mouse previews keep up with it, full quality comes once it rests
+    bool settled = !previewing_ || (std::chrono::steady_clock::now() - julia_moved_ > std::chrono::duration<double>(PREVIEW_SETTLE_TIME));
+    vec2f julia_point = Screen2Base(vec(sf::Mouse::getPosition(*this)));
+    if (options_.julia_dragging && (julia_point != params_.julia_point))
+    {
+        params_.julia_point = julia_point;
+        julia_moved_ = std::chrono::steady_clock::now();
+        renderPreview();
+    }
+    else if ((tuning_ || previewing_) && settled)
     {
-        params_.julia_point = Screen2Base(vec(sf::Mouse::getPosition(*this)));
         render();
     }
     draw(getRenderOutput());
@@ -362,12 +522,15 @@ void Puzabrot::activity()
     {
     case DEFAULT:
     case TRACER:
+    case DISTANCE:
     {
         PARAMETER_BUTTON->show();
         PARAMETER_BUTTON->setText(std::string("LIMIT ") + std::to_string(params_.limit));
         break;
     }
     case COMPLEX_DOMAIN:
+    case NEWTON:
+    case INVERSE_ITERATION:
     {
         PARAMETER_BUTTON->hide();
         break;
@@ -378,6 +541,12 @@ void Puzabrot::activity()
         PARAMETER_BUTTON->setText(std::string("FREQUENCY ") + std::to_string(params_.frequency));
         break;
     }
+    case ORBIT_DENSITY:
+    {
+        PARAMETER_BUTTON->show();
+        PARAMETER_BUTTON->setText(std::string("EXPOSURE ") + std::to_string(params_.frequency));
+        break;
+    }
     }
 
     draw(ui_);
@@ -455,6 +624,14 @@ void Puzabrot::savePicture()
     sf::Vector2u screenshot_sizes(SCREENSHOT_WIDTH, static_cast<unsigned int>(static_cast<float>(SCREENSHOT_WIDTH) /
         static_cast<float>(getSize().x) * static_cast<float>(getSize().y)));
 
+    // CPU images are streamed to the file instead of going through a texture
+    if ((options_.backend == CPU) || (options_.rendering_mode == ORBIT_DENSITY) || (options_.rendering_mode == INVERSE_ITERATION) ||
+        Renderer::IsDeepZoom(makeRenderJob(vec2u())))
+    {
+        savePoster(filename, vec2u(screenshot_sizes.x, screenshot_sizes.y));
+        return;
+    }
+
     sf::Vector2u old_sizes = getSize();
     setRenderImageSize(vec(screenshot_sizes));
     render();
@@ -466,6 +643,26 @@ void Puzabrot::savePicture()
     display();
 }
 
+void Puzabrot::savePoster(const std::string& filename, const vec2u& size)
+{
+    Poster(makeRenderJob(size)).save(renderer_, filename, [this](double progress)
+    {
+        std::stringstream progress_text;
+        progress_text << "SAVING " << std::fixed << std::setprecision(1) << 100.0 * progress << "%";
+        STATS_LABEL->setText(progress_text.str());
+        STATS_LABEL->show();
+
+        clear();
+        draw(getRenderOutput());
+        draw(ui_);
+        display();
+    });
+
+    render();
+    draw(getRenderOutput());
+    display();
+}
+
 AST::Error Puzabrot::makeShader()
 {
     AST::Error err = AST::Error::OK;
@@ -489,6 +686,8 @@ AST::Error Puzabrot::makeShader()
     }
     synth_->setExpressions(expr_trees_);
 
+    formula_ = (options_.input_mode == Z_INPUT) ? Formula(expr_trees_.z) : Formula(expr_trees_.x, expr_trees_.y);
+
     COND_RETURN(writeShader(), AST::Error::UNIDENTIFIED_VARIABLE);
 
     return err;
@@ -496,10 +695,66 @@ AST::Error Puzabrot::makeShader()
 
 void Puzabrot::render()
 {
-    shader_.setUniform("borders.left", static_cast<float>(getBorders().left));
-    shader_.setUniform("borders.right", static_cast<float>(getBorders().right));
-    shader_.setUniform("borders.bottom", static_cast<float>(getBorders().bottom));
-    shader_.setUniform("borders.top", static_cast<float>(getBorders().top));
+    tuning_ = false;
+    previewing_ = false;
+    if (options_.showing_atlas && (options_.fractal_mode == MAIN))
+    {
+        renderAtlas();
+        return;
+    }
+
+    if (options_.auto_iteration && ((options_.rendering_mode == DEFAULT) || (options_.rendering_mode == TRACER) || (options_.rendering_mode == DISTANCE)))
+    {
+        tuneIterations();
+    }
+
+    RenderJob job = makeRenderJob(vec2u(render_texture_.getSize().x, render_texture_.getSize().y));
+
+    // The shader takes the reference orbit as a uniform array as long as the driver allows, longer orbits are left to CPU, as are
+    // orbit densities and preimages.
+    // Shader iterates in float, views in a wider precision without a reference orbit are left to CPU as well
+    bool cpu_rendering = (options_.backend == CPU) || (options_.rendering_mode == ORBIT_DENSITY) || (options_.rendering_mode == INVERSE_ITERATION) ||
+        ((job.precision != SINGLE_PRECISION) && !Renderer::IsDeepZoom(job));
+    if (!cpu_rendering && Renderer::IsDeepZoom(job))
+    {
+        ReferenceOrbit reference(job.borders.center(), job.itrn_max, job.limit);
+        cpu_rendering = reference.size() > deep_zoom_orbit_size_;
+        if (!cpu_rendering)
+        {
+            // Two points of the orbit go to every vec4
+            std::vector<sf::Glsl::Vec4> orbit((reference.size() + 1) / 2);
+            for (size_t n = 0; n < reference.size(); ++n)
+            {
+                sf::Glsl::Vec4& pair = orbit[n / 2];
+                ((n % 2 == 0) ? pair.x : pair.z) = static_cast<float>(reference[n].real());
+                ((n % 2 == 0) ? pair.y : pair.w) = static_cast<float>(reference[n].imag());
+            }
+            shader_.setUniformArray("ref_orbit", orbit.data(), orbit.size());
+            shader_.setUniform("ref_length", static_cast<int>(reference.size() - 1));
+            shader_.setUniform("pixel_size", sf::Glsl::Vec2(static_cast<float>(static_cast<double>(job.borders.width()) / job.size.x),
+                                                            static_cast<float>(static_cast<double>(job.borders.height()) / job.size.y)));
+        }
+    }
+
+    if (cpu_rendering && !formula_.empty())
+    {
+        // Rendered off the event loop, a burst of events only keeps the newest view
+        pipeline_.submit(job);
+        return;
+    }
+    pipeline_.cancel();
+    STATS_LABEL->hide();
+
+    // Corner goes as a float pair and the extent on its own, points keep the precision of the view up to the last rounding
+    auto split = [](const DoubleDouble& x)
+    {
+        const float hi = static_cast<float>(x);
+        return sf::Glsl::Vec2(hi, static_cast<float>(x - DoubleDouble(hi)));
+    };
+    shader_.setUniform("borders.left", split(job.borders.left));
+    shader_.setUniform("borders.top", split(job.borders.top));
+    shader_.setUniform("borders.width", static_cast<float>(job.borders.width()));
+    shader_.setUniform("borders.height", static_cast<float>(job.borders.height()));
 
     shader_.setUniform("winsizes", sf::Glsl::Ivec2(sf::Vector2i(render_texture_.getSize())));
 
@@ -508,9 +763,164 @@ void Puzabrot::render()
     shader_.setUniform("frequency", static_cast<float>(1.0F / (1.0F + std::exp(-params_.frequency))));
     shader_.setUniform("julia_point", sf::Glsl::Vec2(sf::Vector2f(vec(params_.julia_point))));
 
+    if ((options_.rendering_mode == DEFAULT) || (options_.rendering_mode == TRACER))
+    {
+        shader_.setUniform("palette", palette_texture_);
+    }
+    if (options_.rendering_mode == TRACER)
+    {
+        shader_.setUniform("trace_frequency", params_.trace_frequency);
+    }
+
     render_texture_.draw(sprite_, &shader_);
 }
 
+void Puzabrot::renderPreview()
+{
+    // Shader renders are not timed, they stay at full quality
+    RenderJob job = makeRenderJob(vec2u(render_texture_.getSize().x, render_texture_.getSize().y));
+    if (((options_.backend != CPU) && (options_.rendering_mode != ORBIT_DENSITY) && (options_.rendering_mode != INVERSE_ITERATION)) || formula_.empty())
+    {
+        render();
+        return;
+    }
+
+    RenderJob preview_job = preview_.previewJob(job);
+    std::vector<uint8_t> preview_pixels(static_cast<size_t>(preview_job.size.x) * preview_job.size.y * 4);
+
+    const auto start = std::chrono::steady_clock::now();
+    renderer_.render(preview_job, preview_pixels.data());
+    preview_.update(std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+
+    pixels_.resize(static_cast<size_t>(job.size.x) * job.size.y * 4);
+    PreviewQuality::Upscale(preview_pixels.data(), preview_job.size, pixels_.data(), job.size);
+    setRenderImage(pixels_.data());
+
+    // Unfinished render of the previous point is dropped
+    pipeline_.cancel();
+    previewing_ = true;
+    tuning_ = false;
+
+    std::stringstream stats_text;
+    stats_text << "PREVIEW 1/" << std::fixed << std::setprecision(1) << static_cast<double>(job.size.x) / static_cast<double>(preview_job.size.x) <<
+        " ITERATION " << preview_job.itrn_max;
+    STATS_LABEL->setText(stats_text.str());
+    STATS_LABEL->show();
+}
+
+void Puzabrot::renderAtlas()
+{
+    // Rendered right away with all threads, the atlas is not refined afterwards
+    pipeline_.cancel();
+    RenderJob job = makeRenderJob(vec2u(render_texture_.getSize().x, render_texture_.getSize().y));
+    JuliaAtlas atlas(job);
+
+    RenderStats stats;
+    pixels_.resize(static_cast<size_t>(job.size.x) * job.size.y * 4);
+    if (!atlas.render(renderer_, pixels_.data(), &stats))
+    {
+        return;
+    }
+    setRenderImage(pixels_.data());
+
+    const double tiles_num = static_cast<double>(atlas.tiles().x) * static_cast<double>(atlas.tiles().y);
+    std::stringstream stats_text;
+    stats_text << "ATLAS " << atlas.tiles().x << "x" << atlas.tiles().y << " " << std::fixed << std::setprecision(1) <<
+        tiles_num / std::max(stats.time, 1e-6) << " TILES/S " << static_cast<double>(stats.pixels) / std::max(stats.time, 1e-6) * 1e-6 << " MPIXELS/S";
+    STATS_LABEL->setText(stats_text.str());
+    STATS_LABEL->show();
+}
+
+void Puzabrot::showResult(const RenderResult& result)
+{
+    // Results made for another window size are dropped, a render for the new one is on the way
+    const RenderJob& job = result.job;
+    if ((job.size.x != render_texture_.getSize().x) || (job.size.y != render_texture_.getSize().y))
+    {
+        return;
+    }
+    setRenderImage(result.pixels.data());
+
+    const RenderStats& stats = result.stats;
+    const CacheStats& cache_stats = result.cache_stats;
+    const bool promoting = (job.precision != SINGLE_PRECISION) && !Renderer::IsDeepZoom(job);
+    const bool adaptive = job.adaptive_antialiasing && (job.antialiasing > 0);
+    auto percent = [](size_t count, size_t total) { return 100.0 * static_cast<double>(count) / static_cast<double>(std::max<size_t>(total, 1)); };
+
+    std::stringstream stats_text;
+    stats_text << std::fixed << std::setprecision(1);
+    if (promoting && (stats.pixels != 0))
+    {
+        stats_text << "PROMOTED " << percent(stats.promoted, stats.pixels) << "% ";
+    }
+    if (adaptive && (stats.pixels != 0))
+    {
+        stats_text << "REFINED " << percent(stats.refined, stats.pixels) << "% ";
+    }
+    if (stats.time > 0.0)
+    {
+        stats_text << "TAIL " << 100.0 * stats.tail / stats.time << "% ";
+    }
+    if (result.caching)
+    {
+        stats_text << "CACHE HITS " << percent(cache_stats.hits, cache_stats.hits + cache_stats.misses) << "% " <<
+            (cache_stats.bytes >> 20) << "MB";
+    }
+    if (!stats_text.str().empty())
+    {
+        STATS_LABEL->setText(stats_text.str());
+        STATS_LABEL->show();
+    }
+    else
+    {
+        STATS_LABEL->hide();
+    }
+}
+
+RenderJob Puzabrot::makeRenderJob(const vec2u& size) const
+{
+    RenderJob job;
+    job.formula = formula_;
+    job.fractal_mode = options_.fractal_mode;
+    job.rendering_mode = options_.rendering_mode;
+    job.antialiasing = options_.antialiasing;
+    job.adaptive_antialiasing = options_.adaptive_antialiasing;
+    job.itrn_max = params_.itrn_max;
+    job.limit = params_.limit;
+    job.frequency = params_.frequency;
+    job.julia_point = params_.julia_point;
+    job.borders = getBorders<DoubleDouble>();
+    job.size = size;
+    job.precision = getPrecision();
+    job.deep_zoom = options_.deep_zoom;
+    job.palette = options_.palette;
+    job.trace_frequency = params_.trace_frequency;
+    return job;
+}
+
+void Puzabrot::tuneIterations()
+{
+    // Escape statistics of a coarse probe of the view set the limit, a change is checked again in the next frame
+    vec2u size = vec2u(render_texture_.getSize().x, render_texture_.getSize().y);
+    RenderJob job = makeRenderJob(vec2u(ITERATION_PROBE_WIDTH, std::max<uint32_t>(ITERATION_PROBE_WIDTH * size.y / std::max<uint32_t>(size.x, 1), 1)));
+    job.antialiasing = 0;
+    job.adaptive_antialiasing = false;
+
+    std::vector<SampleData> samples(static_cast<size_t>(job.size.x) * job.size.y);
+    renderer_.render(job, samples.data());
+
+    size_t itrn_max = tuner_.tune(EscapeHistogram(samples.data(), samples.size(), job.itrn_max));
+    tuning_ = itrn_max != params_.itrn_max;
+    params_.itrn_max = itrn_max;
+}
+
+void Puzabrot::updatePalette()
+{
+    std::vector<uint8_t> palette = Palette(options_.palette).toRGBA();
+    palette_texture_.create(static_cast<unsigned>(PALETTE_SIZE), 1);
+    palette_texture_.update(palette.data());
+}
+
 int Puzabrot::writeShader()
 {
     std::string str_functions = writeFunctions();
@@ -518,15 +928,36 @@ int Puzabrot::writeShader()
     std::string str_main = writeMain();
     COND_RETURN(str_main.empty(), -1);
 
+    // GL 3.0 guarantees only 1024 fragment uniform components, the orbit takes what the driver has left after the others
+    if (deep_zoom_orbit_size_ == 0)
+    {
+        GLint components = 0;
+        glGetIntegerv(GL_MAX_FRAGMENT_UNIFORM_COMPONENTS, &components);
+        deep_zoom_orbit_size_ = std::clamp<size_t>(static_cast<size_t>(std::max(components - DEEP_ZOOM_RESERVED_UNIFORMS, 0) / 4 * 2), 2,
+                                                   DEEP_ZOOM_ORBIT_SIZE);
+    }
+
+    std::string str_deep_zoom = Renderer::IsDeepZoom(makeRenderJob(vec2u())) ?
+        "uniform vec4    ref_orbit[" + std::to_string(deep_zoom_orbit_size_ / 2) + "];\n"
+        "uniform int     ref_length;\n"
+        "uniform vec2    pixel_size;\n"
+        "\n"
+        "vec2 refOrbit(int m)\n"
+        "{\n"
+        "   vec4 pair = ref_orbit[m / 2];\n"
+        "   return (m % 2 == 0) ? pair.xy : pair.zw;\n"
+        "}\n" :
+        "";
+
     std::string str_shader =
         "#version 130\n"
         "\n"
         "struct Borders\n"
         "{\n"
-        "   float left;\n"
-        "   float right;\n"
-        "   float bottom;\n"
-        "   float top;\n"
+        "   vec2  left;\n"
+        "   vec2  top;\n"
+        "   float width;\n"
+        "   float height;\n"
         "};\n"
         "\n"
         "uniform Borders borders;\n"
@@ -535,6 +966,7 @@ int Puzabrot::writeShader()
         "uniform float   limit;\n"
         "uniform float   frequency;\n"
         "uniform vec2    julia_point;\n"
+            + str_deep_zoom +
         "\n"
             + str_functions +
         "\n"
@@ -724,12 +1156,13 @@ std::string Puzabrot::writeColorFunction() const
     case TRACER:
     {
         str +=
-            "const float K = PI / 3.0;\n"
+            "const int PALETTE_SIZE = " + std::to_string(PALETTE_SIZE) + ";\n"
             "\n"
-            "float pf(float x)\n"
-            "{\n"
-            "    return min(max(acos(cos(x * K)) / K - 1.0F, 0.0), 1.0);\n"
-            "}\n"
+            "uniform sampler2D palette;\n";
+
+        str += (options_.rendering_mode == TRACER) ?
+            "uniform float     trace_frequency;\n"
+            "\n" :
             "\n";
 
         str += (options_.rendering_mode == DEFAULT) ?
@@ -740,14 +1173,13 @@ std::string Puzabrot::writeColorFunction() const
             "{\n"
             "if (itrn < itrn_max)\n"
             "{\n"
-            "    float x = float(itrn) * 4.0 / 255.0;\n"
-            "    return vec3(pf(x - 3.0F), pf(x - 5.0F), pf(x - 7.0F));\n"
+            "    return texture(palette, vec2((float(itrn % PALETTE_SIZE) + 0.5) / float(PALETTE_SIZE), 0.5)).rgb;\n"
             "}\n";
 
         str += (options_.rendering_mode == DEFAULT) ?
             "return vec3(0.0, 0.0, 0.0);\n"
             "}\n" :
-            "return sin(abs(sum / itrn_max * 5.0)) * 0.5 + 0.5;\n"
+            "return sin(abs(sum / itrn_max * trace_frequency)) * 0.5 + 0.5;\n"
             "}\n";
         break;
     }
@@ -778,6 +1210,43 @@ std::string Puzabrot::writeColorFunction() const
             "}\n";
         break;
     }
+    case DISTANCE:
+    {
+        str +=
+            "const float DISTANCE_WIDTH = " + std::to_string(DISTANCE_WIDTH) + ";\n"
+            "\n"
+            "vec3 getColor(int itrn, float estimate)\n"
+            "{\n"
+            "if ((itrn < itrn_max) && !isnan(estimate) && !isinf(estimate))\n"
+            "{\n"
+            "    return vec3(sqrt(clamp(estimate / DISTANCE_WIDTH, 0.0, 1.0)));\n"
+            "}\n"
+            "return vec3(0.0, 0.0, 0.0);\n"
+            "}\n";
+        break;
+    }
+    case NEWTON:
+    {
+        str +=
+            "const float NEWTON_TOLERANCE = " + std::to_string(NEWTON_TOLERANCE) + ";\n"
+            "const float NEWTON_FADE = " + std::to_string(NEWTON_FADE) + ";\n"
+            "\n"
+            "vec3 getColor(int itrn, vec2 root, float last_step)\n"
+            "{\n"
+            "if (itrn < itrn_max)\n"
+            "{\n"
+            "    float magnitude = length(root);\n"
+            "    float phase = (magnitude > NIL) ? atan(root.y, root.x) : 0.0;\n"
+            "    float fraction = clamp(log2(log(max(last_step, NIL * NIL)) / log(NEWTON_TOLERANCE)), 0.0, 1.0);\n"
+            "    vec3 c = vec3((phase + atan(log(max(magnitude, NIL)))) / (2.0 * PI), 1.0, pow(NEWTON_FADE, float(itrn) - fraction));\n"
+            "    vec4 K = vec4(1.0, 2.0 / 3.0, 1.0 / 3.0, 3.0);\n"
+            "    vec3 p = abs(fract(c.xxx + K.xyz) * 6.0 - K.www);\n"
+            "    return c.z * mix(K.xxx, clamp(p - K.xxx, 0.0, 1.0), c.y);\n"
+            "}\n"
+            "return vec3(0.0, 0.0, 0.0);\n"
+            "}\n";
+        break;
+    }
     }
     return str;
 }
@@ -796,7 +1265,7 @@ std::string Puzabrot::writeInitialization() const
             "vec2 c = vec2(re0, im0);\n" :
             "vec2 c = vec2(julia_point.x, julia_point.y);";
 
-        str += (options_.rendering_mode == TRACER) ?
+        str += ((options_.rendering_mode == TRACER) || (options_.rendering_mode == NEWTON)) ?
             "vec2 pz = z;\n" :
             "";
         break;
@@ -813,7 +1282,7 @@ std::string Puzabrot::writeInitialization() const
             "float cx = julia_point.x;\n"
             "float cy = julia_point.y;\n";
 
-        str += (options_.rendering_mode == TRACER) ?
+        str += ((options_.rendering_mode == TRACER) || (options_.rendering_mode == NEWTON)) ?
             "vec2 pz = vec2(x, y);\n" :
             "";
 
@@ -828,12 +1297,42 @@ std::string Puzabrot::writeInitialization() const
         "float weight = 1.0;\n" :
         "";
 
+    if (options_.rendering_mode == DISTANCE)
+    {
+        str += (options_.input_mode == Z_INPUT) ?
+            "vec2 dz = ONE;\n" :
+            "mat2 dz = mat2(1.0);\n";
+    }
+
+    return str;
+}
+
+std::string Puzabrot::writeInteriorChecking() const
+{
+    std::string str;
+    if (formula_.isQuadratic() && (options_.fractal_mode == MAIN) && ((options_.rendering_mode == DEFAULT) || (options_.rendering_mode == DISTANCE)))
+    {
+        str +=
+            "float xq = re0 - 0.25;\n"
+            "float q  = xq * xq + im0 * im0;\n"
+            "float xp = re0 + 1.0;\n"
+            "if ((limit >= 2.0) && ((q * (q + xq) <= 0.25 * im0 * im0) || (xp * xp + im0 * im0 <= 0.0625))) itrn = itrn_max;\n";
+    }
     return str;
 }
 
 std::string Puzabrot::writeCalculation() const
 {
+    COND_RETURN(options_.rendering_mode == NEWTON, writeNewtonStep());
+
     std::string str;
+    if (options_.rendering_mode == DISTANCE)
+    {
+        // Derivatives step from the point the formula is about to replace
+        str += writeDerivative();
+        COND_RETURN(str.empty(), std::string());
+    }
+
     switch (options_.input_mode)
     {
     case Z_INPUT:
@@ -878,6 +1377,114 @@ std::string Puzabrot::writeCalculation() const
     return str;
 }
 
+std::string Puzabrot::writeDerivative() const
+{
+    std::string str;
+    switch (options_.input_mode)
+    {
+    case Z_INPUT:
+    {
+        std::vector<ASTz> derivatives = Formula::Derivatives(expr_trees_.z);
+
+        str +=
+            "dz = cmul(";
+
+        COND_RETURN(Tree2GLSL(derivatives[0], &str), std::string());
+
+        str += ", dz)";
+        if (options_.fractal_mode == MAIN)
+        {
+            str += " + ";
+            COND_RETURN(Tree2GLSL(derivatives[1], &str), std::string());
+        }
+
+        str += ";\n";
+        break;
+    }
+    case XY_INPUT:
+    {
+        // Rows of the Jacobian by x, y and by cx, cy become the columns GLSL builds matrices from
+        std::vector<ASTx> derivatives = Formula::Derivatives(expr_trees_.x, expr_trees_.y);
+        auto write_matrix = [&](size_t first)
+        {
+            str += "mat2(";
+            for (size_t ind : { first, first + 4, first + 1, first + 5 })
+            {
+                COND_RETURN(Tree2GLSL(derivatives[ind], &str), false);
+                str += (ind == first + 5) ? ".x)" : ".x, ";
+            }
+            return true;
+        };
+
+        str +=
+            "dz = ";
+
+        COND_RETURN(!write_matrix(0), std::string());
+
+        str += " * dz";
+        if (options_.fractal_mode == MAIN)
+        {
+            str += " + ";
+            COND_RETURN(!write_matrix(2), std::string());
+        }
+
+        str += ";\n";
+        break;
+    }
+    }
+    return str;
+}
+
+std::string Puzabrot::writeNewtonStep() const
+{
+    std::string str;
+    switch (options_.input_mode)
+    {
+    case Z_INPUT:
+    {
+        std::vector<ASTz> derivatives = Formula::Derivatives(expr_trees_.z);
+
+        str +=
+            "pz = z;\n"
+            "z = csub(z, cdiv(";
+
+        COND_RETURN(Tree2GLSL(expr_trees_.z, &str), std::string());
+
+        str += ", ";
+
+        COND_RETURN(Tree2GLSL(derivatives[0], &str), std::string());
+
+        str += "));\n";
+        break;
+    }
+    case XY_INPUT:
+    {
+        // Both parts and the Jacobian by x and y, solved by Cramer's rule
+        std::vector<ASTx> derivatives = Formula::Derivatives(expr_trees_.x, expr_trees_.y);
+        const std::pair<const char*, const ASTx*> values[] = {
+            { "fx", &expr_trees_.x }, { "fy", &expr_trees_.y },
+            { "jxx", &derivatives[0] }, { "jxy", &derivatives[1] }, { "jyx", &derivatives[4] }, { "jyy", &derivatives[5] } };
+
+        str +=
+            "pz = vec2(x, y);\n";
+
+        for (const auto& [name, tree] : values)
+        {
+            str += "float " + std::string(name) + " = ";
+            COND_RETURN(Tree2GLSL(*tree, &str), std::string());
+            str += ".x;\n";
+        }
+
+        str +=
+            "float det = jxx * jyy - jxy * jyx;\n"
+            "x -= (jyy * fx - jxy * fy) / det;\n"
+            "y -= (jxx * fy - jyx * fx) / det;\n";
+        break;
+    }
+    }
+    return str;
+}
+
 std::string Puzabrot::writeChecking() const
 {
     std::string str;
@@ -885,6 +1492,7 @@ std::string Puzabrot::writeChecking() const
     {
     case DEFAULT:
     case TRACER:
+    case DISTANCE:
     {
         str += (options_.input_mode == XY_INPUT) ?
             "vec2 z = vec2(x, y);\n" :
@@ -900,6 +1508,16 @@ std::string Puzabrot::writeChecking() const
             "";
         break;
     }
+    case NEWTON:
+    {
+        str += (options_.input_mode == XY_INPUT) ?
+            "vec2 z = vec2(x, y);\n" :
+            "";
+
+        str +=
+            "if (dot(z - pz, z - pz) <= NEWTON_TOLERANCE * NEWTON_TOLERANCE * max(dot(z, z), 1.0)) break;\n";
+        break;
+    }
     case COMPLEX_DOMAIN:
     {
         break;
@@ -924,7 +1542,10 @@ std::string Puzabrot::writeChecking() const
 
 std::string Puzabrot::writeMain() const
 {
+    COND_RETURN(Renderer::IsDeepZoom(makeRenderJob(vec2u())), writeDeepZoomMain());
+
     std::string str_initialization = writeInitialization();
+    std::string str_interior_checking = writeInteriorChecking();
 
     std::string str_calculation = writeCalculation();
     COND_RETURN(str_calculation.empty(), std::string());
@@ -947,12 +1568,13 @@ std::string Puzabrot::writeMain() const
         "for (int sx = 0; sx < AA; sx++)\n"
         "for (int sy = 0; sy < AA; sy++)\n"
         "{\n"
-        "float re0 = borders.left + (borders.right - borders.left) * (gl_FragCoord.x + float(sx) / float(AA)) / winsizes.x;\n"
-        "float im0 = borders.top  - (borders.top - borders.bottom) * (gl_FragCoord.y + float(sy) / float(AA)) / winsizes.y;\n"
+        "float re0 = borders.left.x + (borders.left.y + borders.width * (gl_FragCoord.x + float(sx) / float(AA)) / winsizes.x);\n"
+        "float im0 = borders.top.x  + (borders.top.y - borders.height * (gl_FragCoord.y + float(sy) / float(AA)) / winsizes.y);\n"
         "\n"
             + str_initialization +
-        "int itrn;\n"
-        "for (itrn = 0; itrn < itrn_max; ++itrn)\n"
+        "int itrn = 0;\n"
+            + str_interior_checking +
+        "for (; itrn < itrn_max; ++itrn)\n"
         "{\n"
             + str_calculation +
         "\n"
@@ -986,6 +1608,29 @@ std::string Puzabrot::writeMain() const
             "col += getColor(sum);\n";
         break;
     }
+    case DISTANCE:
+    {
+        // |z| log|z| / |dz| in pixels, the norm of the Jacobian is the one of a complex derivative for holomorphic formulas
+        str += (options_.input_mode == Z_INPUT) ?
+            "float radius = length(z);\n"
+            "float dz_norm = length(dz);\n" :
+            "float radius = length(vec2(x, y));\n"
+            "float dz_norm = sqrt(0.5 * (dot(dz[0], dz[0]) + dot(dz[1], dz[1])));\n";
+
+        str +=
+            "col += getColor(itrn, radius * log(radius) / dz_norm / (borders.width / float(winsizes.x)));\n";
+        break;
+    }
+    case NEWTON:
+    {
+        str += (options_.input_mode == Z_INPUT) ?
+            "vec2 root = z;\n" :
+            "vec2 root = vec2(x, y);\n";
+
+        str +=
+            "col += getColor(itrn, root, length(root - pz) / max(length(root), 1.0));\n";
+        break;
+    }
     }
 
     str +=
@@ -996,6 +1641,45 @@ std::string Puzabrot::writeMain() const
     return str;
 }
 
+std::string Puzabrot::writeDeepZoomMain() const
+{
+    std::string str;
+    switch (options_.antialiasing)
+    {
+    case 0: str += "const int AA = 1;\n"; break;
+    case 1: str += "const int AA = 2;\n"; break;
+    case 2: str += "const int AA = 3;\n"; break;
+    case 3: str += "const int AA = 4;\n"; break;
+    }
+
+    str +=
+        "void main()\n"
+        "{\n"
+        "vec3 col = vec3(0.0);\n"
+        "for (int sx = 0; sx < AA; sx++)\n"
+        "for (int sy = 0; sy < AA; sy++)\n"
+        "{\n"
+        "vec2 dc = vec2(gl_FragCoord.x + float(sx) / float(AA) - 0.5 * float(winsizes.x),\n"
+        "               0.5 * float(winsizes.y) - gl_FragCoord.y - float(sy) / float(AA)) * pixel_size;\n"
+        "vec2 dz = vec2(0.0, 0.0);\n"
+        "int m = 0;\n"
+        "int itrn = itrn_max;\n"
+        "for (int n = 1; n <= itrn_max + 1; ++n)\n"
+        "{\n"
+        "dz = cmul(2.0 * refOrbit(m) + dz, dz) + dc;\n"
+        "++m;\n"
+        "vec2 z = refOrbit(m) + dz;\n"
+        "if ((n >= 2) && (dot(z, z) > limit * limit)) { itrn = n - 2; break; }\n"
+        "if ((dot(z, z) < dot(dz, dz)) || (m == ref_length)) { dz = z; m = 0; }\n"
+        "}\n"
+        "col += getColor(itrn);\n"
+        "}\n"
+        "gl_FragColor = vec4(col / float(AA * AA), 1.0);\n"
+        "}";
+
+    return str;
+}
+
 using ASTNodez = ast::ASTNode<std::complex<float>>;
 using OperationNodez = ast::OperationNode<std::complex<float>>;
 using FunctionNodez = ast::FunctionNode<std::complex<float>>;
@@ -0,0 +1,146 @@
+#include "Render/CostModel.h"
+#include "Render/Renderer.h"
+
+#include <algorithm>
+
+bool CostModel::similar(const RenderJob& job) const
+{
+    // Julia point, iteration limit and view may change, the costs are then off in scale but not in order
+    return !frames_.empty() && (formula_ == job.formula) && (fractal_mode_ == job.fractal_mode) && (rendering_mode_ == job.rendering_mode) &&
+        (antialiasing_ == job.antialiasing);
+}
+
+void CostModel::predict(const RenderJob& job, std::vector<RowSpan>* spans) const
+{
+    // Pixels of the job in pixels of every recorded frame, offsets between the views are taken in double-double,
+    // deep zooms move by less than a double ulp of the position
+    struct Lookup final
+    {
+        const Frame* frame;
+        double offset_x;
+        double step_x;
+        double offset_y;
+        double step_y;
+    };
+
+    std::vector<Lookup> lookups;
+    for (const Frame& frame : frames_)
+    {
+        const double pixels_x = static_cast<double>(frame.size.x) / static_cast<double>(frame.borders.width());
+        const double pixels_y = static_cast<double>(frame.size.y) / static_cast<double>(frame.borders.height());
+        lookups.push_back({ &frame,
+            pixels_x * static_cast<double>(job.borders.left - frame.borders.left),
+            pixels_x * static_cast<double>(job.borders.width()) / static_cast<double>(job.size.x),
+            pixels_y * static_cast<double>(frame.borders.top - job.borders.top),
+            pixels_y * static_cast<double>(job.borders.height()) / static_cast<double>(job.size.y) });
+    }
+
+    std::vector<const Lookup*> overlaps;
+    for (RowSpan& span : *spans)
+    {
+        overlaps.clear();
+        for (const Lookup& lookup : lookups)
+        {
+            const double left = lookup.offset_x + lookup.step_x * static_cast<double>(span.col_begin);
+            const double right = lookup.offset_x + lookup.step_x * static_cast<double>(span.col_end);
+            const double top = lookup.offset_y + lookup.step_y * static_cast<double>(span.row);
+            const double bottom = lookup.offset_y + lookup.step_y * static_cast<double>(span.row + span.rows * span.row_step);
+            if ((right > 0.0) && (left < static_cast<double>(lookup.frame->size.x)) && (bottom > 0.0) && (top < static_cast<double>(lookup.frame->size.y)))
+            {
+                overlaps.push_back(&lookup);
+            }
+        }
+
+        span.cost = 0.0;
+        for (uint32_t i = 0; i < span.rows; ++i)
+        {
+            const double row = static_cast<double>(span.row + i * span.row_step) + 0.5;
+            for (uint32_t col = span.col_begin; col < span.col_end; col += span.col_step)
+            {
+                double pixel_cost = frames_.front().mean_cost;
+                for (const Lookup* lookup : overlaps)
+                {
+                    const double x = lookup->offset_x + lookup->step_x * (static_cast<double>(col) + 0.5);
+                    const double y = lookup->offset_y + lookup->step_y * row;
+                    if ((y >= 0.0) && (y < static_cast<double>(lookup->frame->size.y)) && (x >= 0.0) && (x < static_cast<double>(lookup->frame->size.x)))
+                    {
+                        pixel_cost = lookup->frame->cell_costs[static_cast<size_t>(y) * lookup->frame->cells_x + static_cast<size_t>(x) / COST_CELL_WIDTH];
+                        break;
+                    }
+                }
+                span.cost += pixel_cost;
+            }
+        }
+    }
+}
+
+void CostModel::record(const RenderJob& job, const std::vector<RowSpan>& spans)
+{
+    // Frames of another fractal stay until the first render of the new one is recorded, it is predicted from them
+    if (!similar(job) || (fingerprint_ != Renderer::Fingerprint(job)))
+    {
+        frames_.clear();
+        cells_ = 0;
+    }
+    formula_ = job.formula;
+    fractal_mode_ = job.fractal_mode;
+    rendering_mode_ = job.rendering_mode;
+    antialiasing_ = job.antialiasing;
+    fingerprint_ = Renderer::Fingerprint(job);
+
+    Frame frame = { job.borders, job.size, (job.size.x + COST_CELL_WIDTH - 1) / COST_CELL_WIDTH, {}, 0.0 };
+    std::vector<double> sums(static_cast<size_t>(frame.cells_x) * job.size.y);
+    std::vector<uint32_t> counts(sums.size());
+    double total = 0.0;
+    size_t pixels = 0;
+
+    for (const RowSpan& span : spans)
+    {
+        const uint32_t span_pixels = (span.col_end - span.col_begin + span.col_step - 1) / span.col_step * span.rows;
+        if (span_pixels == 0)
+        {
+            continue;
+        }
+
+        const double pixel_cost = span.cost / static_cast<double>(span_pixels);
+        for (uint32_t i = 0; i < span.rows; ++i)
+        {
+            for (uint32_t col = span.col_begin; col < span.col_end; col += span.col_step)
+            {
+                size_t cell = static_cast<size_t>(span.row + i * span.row_step) * frame.cells_x + col / COST_CELL_WIDTH;
+                sums[cell] += pixel_cost;
+                ++counts[cell];
+            }
+        }
+        total += span.cost;
+        pixels += span_pixels;
+    }
+    if (pixels == 0)
+    {
+        return;
+    }
+
+    // Cells with no rendered pixel, the ones copied by an incremental render, take the mean
+    frame.mean_cost = total / static_cast<double>(pixels);
+    frame.cell_costs.resize(sums.size());
+    for (size_t cell = 0; cell < sums.size(); ++cell)
+    {
+        frame.cell_costs[cell] = static_cast<float>((counts[cell] != 0) ? sums[cell] / counts[cell] : frame.mean_cost);
+    }
+
+    // Older frames inside the new one are never looked up again, the oldest ones go once the cells are over the budget
+    std::erase_if(frames_, [&](const Frame& old)
+    {
+        const bool covered = !(old.borders.left < frame.borders.left) && !(old.borders.right > frame.borders.right) &&
+            !(old.borders.bottom < frame.borders.bottom) && !(old.borders.top > frame.borders.top);
+        cells_ -= covered ? old.cell_costs.size() : 0;
+        return covered;
+    });
+    cells_ += frame.cell_costs.size();
+    frames_.push_front(std::move(frame));
+    while ((frames_.size() > 1) && (cells_ > COST_MODEL_CELLS))
+    {
+        cells_ -= frames_.back().cell_costs.size();
+        frames_.pop_back();
+    }
+}
@@ -0,0 +1,409 @@
+#include "Render/Distributed.h"
+#include "Render/PngStream.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <csignal>
+#include <cstring>
+#include <deque>
+#include <map>
+#include <poll.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace
+{
+struct MessageHeader final
+{
+    uint32_t type;
+    uint64_t tile;
+    uint64_t size;
+};
+
+bool writeAll(int fd, const char* data, size_t size)
+{
+    while (size > 0)
+    {
+        ssize_t written = ::write(fd, data, size);
+        if (written < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            return false;
+        }
+        data += written;
+        size -= static_cast<size_t>(written);
+    }
+    return true;
+}
+
+bool readAll(int fd, char* data, size_t size)
+{
+    while (size > 0)
+    {
+        ssize_t was_read = ::read(fd, data, size);
+        if (was_read < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            return false;
+        }
+        if (was_read == 0)
+        {
+            return false;
+        }
+        data += was_read;
+        size -= static_cast<size_t>(was_read);
+    }
+    return true;
+}
+
+size_t resultSize(const RenderTask& task, size_t tile)
+{
+    const vec2u position = task.tilePosition(tile);
+    const size_t cols = std::min(task.tile_size.x, task.job.size.x - position.x);
+    const size_t rows = std::min(task.tile_size.y, task.job.size.y - position.y);
+    return cols * rows * 3;
+}
+}
+
+Channel::Channel(int read_fd, int write_fd, size_t max_payload) : read_fd_(read_fd), write_fd_(write_fd), max_payload_(max_payload) {}
+
+bool Channel::send(const Message& message) const
+{
+    // Zeroed first, so the padding after the type is not written to the channel uninitialized
+    MessageHeader header;
+    std::memset(&header, 0, sizeof(header));
+    header.type = message.type;
+    header.tile = message.tile;
+    header.size = message.payload.size();
+    return writeAll(write_fd_, reinterpret_cast<const char*>(&header), sizeof(header)) &&
+           writeAll(write_fd_, message.payload.data(), message.payload.size());
+}
+
+bool Channel::receive(Message* message) const
+{
+    MessageHeader header = {};
+    if (!readAll(read_fd_, reinterpret_cast<char*>(&header), sizeof(header)) || (header.size > max_payload_))
+    {
+        return false;
+    }
+
+    message->type = header.type;
+    message->tile = header.tile;
+    message->payload.resize(header.size);
+    return readAll(read_fd_, message->payload.data(), header.size);
+}
+
+int Channel::readFd() const
+{
+    return read_fd_;
+}
+
+void Channel::close()
+{
+    if (read_fd_ >= 0)
+    {
+        ::close(read_fd_);
+    }
+    if ((write_fd_ >= 0) && (write_fd_ != read_fd_))
+    {
+        ::close(write_fd_);
+    }
+    read_fd_ = -1;
+    write_fd_ = -1;
+}
+
+int Worker::Run(const Channel& channel)
+{
+    Message message;
+    if (!channel.receive(&message) || (message.type != TASK_MESSAGE))
+    {
+        return 1;
+    }
+
+    RenderTask task;
+    if (!RenderTask::Parse(message.payload, &task))
+    {
+        return 1;
+    }
+
+    // Parallelism comes from the number of workers
+    Renderer renderer(1);
+    std::vector<SampleData> data;
+    std::vector<uint8_t> pixels;
+
+    while (channel.receive(&message))
+    {
+        if (message.type != TILE_MESSAGE)
+        {
+            return (message.type == QUIT_MESSAGE) ? 0 : 1;
+        }
+
+        RenderJob job = task.tileJob(message.tile);
+        const size_t pixels_num = static_cast<size_t>(job.size.x) * job.size.y;
+        data.resize(Renderer::SamplesNum(job));
+        pixels.resize(pixels_num * 4);
+
+        renderer.render(job, data.data());
+        Renderer::Colorize(job, data.data(), pixels.data());
+
+        Message result = {RESULT_MESSAGE, message.tile, std::string(pixels_num * 3, '\0')};
+        for (size_t i = 0; i < pixels_num; ++i)
+        {
+            std::copy_n(pixels.data() + i * 4, 3, result.payload.data() + i * 3);
+        }
+
+        if (!channel.send(result))
+        {
+            return 1;
+        }
+    }
+
+    return 1;
+}
+
+Coordinator::Coordinator(size_t workers_num) : workers_(std::max(workers_num, size_t(1))) {}
+
+Coordinator::~Coordinator()
+{
+    stopAll();
+}
+
+bool Coordinator::save(const RenderTask& task, const std::string& filename, const std::function<void(double)>& progress)
+{
+    const RenderJob& job = task.job;
+    if ((job.size.x == 0) || (job.size.y == 0) || job.formula.empty() || (task.tile_size.x == 0) || (task.tile_size.y == 0))
+    {
+        return false;
+    }
+
+    PngStream stream(filename, job.size.x, job.size.y);
+    if (!stream.good())
+    {
+        return false;
+    }
+
+    // A dead worker shows up as a failed write, which must not kill the coordinator
+    std::signal(SIGPIPE, SIG_IGN);
+
+    const std::string task_text = task.serialize();
+    const size_t max_result = static_cast<size_t>(task.tile_size.x) * task.tile_size.y * 3;
+    for (WorkerProcess& worker : workers_)
+    {
+        if (!spawn(&worker, task_text, max_result))
+        {
+            stopAll();
+            return false;
+        }
+    }
+
+    const size_t tiles_x = task.tilesX();
+    const size_t tiles_y = task.tilesY();
+
+    std::deque<size_t> queue;
+    for (size_t tile = 0; tile < tiles_x * tiles_y; ++tile)
+    {
+        queue.push_back(tile);
+    }
+
+    std::vector<size_t> attempts(tiles_x * tiles_y, 0);
+    std::map<size_t, std::string> results;
+    std::vector<uint8_t> band(static_cast<size_t>(job.size.x) * task.tile_size.y * 3);
+    size_t tile_row = 0;
+    bool failed = false;
+
+    while ((tile_row < tiles_y) && !failed)
+    {
+        // Hand out tiles, but only from the rows close to the one being written
+        for (WorkerProcess& worker : workers_)
+        {
+            if ((worker.tile != NO_TILE) || queue.empty() || (queue.front() / tiles_x >= tile_row + TILE_ROWS_IN_FLIGHT))
+            {
+                continue;
+            }
+
+            worker.tile = queue.front();
+            queue.pop_front();
+            if (!worker.channel.send({TILE_MESSAGE, worker.tile, {}}))
+            {
+                queue.push_front(worker.tile);
+                worker.tile = NO_TILE;
+            }
+        }
+
+        std::vector<pollfd> fds;
+        for (const WorkerProcess& worker : workers_)
+        {
+            fds.push_back({worker.channel.readFd(), POLLIN, 0});
+        }
+
+        if ((::poll(fds.data(), fds.size(), -1) < 0) && (errno != EINTR))
+        {
+            failed = true;
+            break;
+        }
+
+        for (size_t i = 0; i < workers_.size(); ++i)
+        {
+            WorkerProcess& worker = workers_[i];
+            if (fds[i].revents == 0)
+            {
+                continue;
+            }
+
+            Message message;
+            bool alive = worker.channel.receive(&message) && (message.type == RESULT_MESSAGE) && (message.tile == worker.tile) &&
+                         (message.payload.size() == resultSize(task, worker.tile));
+            if (alive)
+            {
+                results[worker.tile] = std::move(message.payload);
+                worker.tile = NO_TILE;
+                continue;
+            }
+
+            // Worker died or broke the protocol, its tile goes back to the front of the queue
+            if (worker.tile != NO_TILE)
+            {
+                if (++attempts[worker.tile] >= MAX_TILE_ATTEMPTS)
+                {
+                    failed = true;
+                    break;
+                }
+                queue.push_front(worker.tile);
+                ++retries_;
+            }
+
+            stop(&worker, true);
+            if (!spawn(&worker, task_text, max_result))
+            {
+                failed = true;
+                break;
+            }
+        }
+
+        // Write every tile row that is complete
+        while ((tile_row < tiles_y) && !failed)
+        {
+            const size_t first = tile_row * tiles_x;
+            bool complete = true;
+            for (size_t tile = first; (tile < first + tiles_x) && complete; ++tile)
+            {
+                complete = results.contains(tile);
+            }
+            if (!complete)
+            {
+                break;
+            }
+
+            const uint32_t row = static_cast<uint32_t>(tile_row) * task.tile_size.y;
+            const uint32_t rows = std::min(task.tile_size.y, job.size.y - row);
+            for (size_t tile = first; tile < first + tiles_x; ++tile)
+            {
+                const vec2u position = task.tilePosition(tile);
+                const uint32_t cols = std::min(task.tile_size.x, job.size.x - position.x);
+                const std::string& rgb = results[tile];
+                for (uint32_t r = 0; r < rows; ++r)
+                {
+                    std::copy_n(rgb.data() + static_cast<size_t>(r) * cols * 3, cols * 3,
+                                band.data() + (static_cast<size_t>(r) * job.size.x + position.x) * 3);
+                }
+                results.erase(tile);
+            }
+
+            stream.writeRows(band.data(), rows);
+            ++tile_row;
+            if (progress)
+            {
+                progress(static_cast<double>(row + rows) / static_cast<double>(job.size.y));
+            }
+        }
+    }
+
+    stopAll();
+    return !failed && stream.good();
+}
+
+size_t Coordinator::retries() const
+{
+    return retries_;
+}
+
+bool Coordinator::spawn(WorkerProcess* worker, const std::string& task_text, size_t max_result)
+{
+    int to_worker[2] = {};
+    int from_worker[2] = {};
+    if (::pipe(to_worker) != 0)
+    {
+        return false;
+    }
+    if (::pipe(from_worker) != 0)
+    {
+        ::close(to_worker[0]);
+        ::close(to_worker[1]);
+        return false;
+    }
+
+    pid_t pid = ::fork();
+    if (pid < 0)
+    {
+        for (int fd : {to_worker[0], to_worker[1], from_worker[0], from_worker[1]})
+        {
+            ::close(fd);
+        }
+        return false;
+    }
+
+    if (pid == 0)
+    {
+        for (WorkerProcess& other : workers_)
+        {
+            other.channel.close();
+        }
+        ::close(to_worker[1]);
+        ::close(from_worker[0]);
+        ::_exit(Worker::Run(Channel(to_worker[0], from_worker[1])));
+    }
+
+    ::close(to_worker[0]);
+    ::close(from_worker[1]);
+    worker->pid = pid;
+    worker->channel = Channel(from_worker[0], to_worker[1], max_result);
+    worker->tile = NO_TILE;
+
+    return worker->channel.send({TASK_MESSAGE, 0, task_text});
+}
+
+void Coordinator::stop(WorkerProcess* worker, bool kill_process)
+{
+    if (worker->pid < 0)
+    {
+        return;
+    }
+
+    if (kill_process)
+    {
+        ::kill(worker->pid, SIGKILL);
+    }
+    else
+    {
+        worker->channel.send({QUIT_MESSAGE, 0, {}});
+    }
+
+    worker->channel.close();
+    ::waitpid(worker->pid, nullptr, 0);
+    worker->pid = -1;
+    worker->tile = NO_TILE;
+}
+
+void Coordinator::stopAll()
+{
+    for (WorkerProcess& worker : workers_)
+    {
+        stop(&worker, worker.tile != NO_TILE);
+    }
+}
@@ -0,0 +1,322 @@
+#include "Render/Formula.h"
+
+#include <algorithm>
+#include <string_view>
+
+static const std::vector<std::string> Z_VARIABLES = { "z", "c" };
+static const std::vector<std::string> XY_VARIABLES = { "x", "y", "cx", "cy" };
+
+// Parity of the expression when the variables of odd_names change sign
+template <typename T>
+static size_t Parity(const ast::AST<T>& tree, const std::vector<std::string>& odd_names)
+{
+    using NodeType = typename ast::ASTNode<T>::Type;
+    using OperationType = typename ast::OperationNode<T>::Type;
+    using FunctionType = typename ast::FunctionNode<T>::Type;
+
+    auto branch = [&tree](size_t ind) { return *static_cast<const ast::AST<T>*>(&tree[ind]); };
+
+    switch (tree.value().get()->NodeType())
+    {
+    case NodeType::NUMBER:
+    {
+        return EVEN_PARITY;
+    }
+    case NodeType::VARIABLE:
+    {
+        const auto& name = static_cast<ast::VariableNode<T>*>(tree.value().get())->name;
+        return (std::find(odd_names.begin(), odd_names.end(), name) != odd_names.end()) ? ODD_PARITY : EVEN_PARITY;
+    }
+    case NodeType::FUNCTION:
+    {
+        const size_t arg = Parity(branch(0), odd_names);
+        if (arg != ODD_PARITY)
+        {
+            return arg;
+        }
+
+        switch (static_cast<ast::FunctionNode<T>*>(tree.value().get())->type)
+        {
+        case FunctionType::ABS:
+        case FunctionType::COS:
+        case FunctionType::COSH:
+            return EVEN_PARITY;
+        case FunctionType::ARCCOTH:
+        case FunctionType::ARCSIN:
+        case FunctionType::ARCSINH:
+        case FunctionType::ARCTAN:
+        case FunctionType::ARCTANH:
+        case FunctionType::COT:
+        case FunctionType::COTH:
+        case FunctionType::SIN:
+        case FunctionType::SINH:
+        case FunctionType::TAN:
+        case FunctionType::TANH:
+            return ODD_PARITY;
+        default:
+            return NO_PARITY;
+        }
+    }
+    case NodeType::OPERATION:
+    {
+        const size_t left = Parity(branch(0), odd_names);
+        if ((tree.branches_num() < 2) || (left == NO_PARITY))
+        {
+            return left;
+        }
+        const size_t right = Parity(branch(1), odd_names);
+        if (right == NO_PARITY)
+        {
+            return NO_PARITY;
+        }
+
+        switch (static_cast<ast::OperationNode<T>*>(tree.value().get())->type)
+        {
+        case OperationType::ADD:
+        case OperationType::SUB:
+            return (left == right) ? left : size_t(NO_PARITY);
+        case OperationType::MUL:
+        case OperationType::DIV:
+            return (left == right) ? EVEN_PARITY : ODD_PARITY;
+        case OperationType::POW:
+        {
+            if ((right != EVEN_PARITY) || (left == EVEN_PARITY))
+            {
+                return (right == EVEN_PARITY) ? EVEN_PARITY : NO_PARITY;
+            }
+
+            // Odd bases keep a parity under whole exponents only
+            Polynomial exponent;
+            if (Polynomial::FromAST(branch(1), {}, &exponent))
+            {
+                auto k = exponent.coefficient({});
+                if ((k.imag() == 0.0) && (std::floor(k.real()) == k.real()))
+                {
+                    return (std::fmod(k.real(), 2.0) == 0.0) ? EVEN_PARITY : ODD_PARITY;
+                }
+            }
+            return NO_PARITY;
+        }
+        default:
+            return NO_PARITY;
+        }
+    }
+    }
+    return NO_PARITY;
+}
+
+// Real numbers and functions that commute with conjugation, which all but arg do on their principal branches
+static bool HasRealCoefficients(const ASTz& tree)
+{
+    using NodeType = ast::ASTNode<std::complex<float>>::Type;
+    using FunctionType = ast::FunctionNode<std::complex<float>>::Type;
+
+    switch (tree.value().get()->NodeType())
+    {
+    case NodeType::NUMBER:
+    {
+        return static_cast<ast::NumberNode<std::complex<float>>*>(tree.value().get())->number.imag() == 0.0F;
+    }
+    case NodeType::FUNCTION:
+    {
+        if (static_cast<ast::FunctionNode<std::complex<float>>*>(tree.value().get())->type == FunctionType::ARG)
+        {
+            return false;
+        }
+        break;
+    }
+    default: break;
+    }
+
+    for (size_t i = 0; i < tree.branches_num(); ++i)
+    {
+        if (!HasRealCoefficients(*static_cast<const ASTz*>(&tree[i])))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Degree n and coefficient a of a z^n + g(c), the rest of the polynomial must not depend on the first z_vars variables
+static bool InverseBranches(const Polynomial& poly, const Polynomial& z, size_t z_vars, unsigned* degree, Polynomial::Coefficient* lead)
+{
+    const unsigned n = poly.degree(0);
+    Polynomial::Monomial monomial(poly.vars_num(), 0);
+    monomial[0] = n;
+    const Polynomial::Coefficient a = poly.coefficient(monomial);
+    if ((n < 2) || (std::abs(a) == 0.0))
+    {
+        return false;
+    }
+
+    const Polynomial rest = poly - z.pow(n) * a;
+    for (const auto& [rest_monomial, k] : rest.terms())
+    {
+        if (std::any_of(rest_monomial.begin(), rest_monomial.begin() + static_cast<ptrdiff_t>(z_vars), [](unsigned power) { return power != 0; }) &&
+            (std::abs(k) > 1e-6 * std::abs(a)))
+        {
+            return false;
+        }
+    }
+
+    *degree = n;
+    *lead = a;
+    return true;
+}
+
+Formula::Formula(const ASTz& z) : input_mode_(Z_INPUT), programs_(1)
+{
+    if (!Compile(z, Z_VARIABLES, &programs_[0]))
+    {
+        programs_.clear();
+        return;
+    }
+    compileDerivatives(Derivatives(z), Z_VARIABLES);
+
+    conjugate_symmetric_ = HasRealCoefficients(z);
+    parity_ = Parity(z, { "z" });
+
+    // z^2 + c
+    Polynomial poly_z;
+    if (Polynomial::FromAST(z, Z_VARIABLES, &poly_z))
+    {
+        const size_t vars_num = Z_VARIABLES.size();
+        Polynomial z_ = Polynomial::Variable(vars_num, 0);
+        Polynomial c_ = Polynomial::Variable(vars_num, 1);
+
+        quadratic_ = poly_z.isApprox(z_ * z_ + c_);
+        InverseBranches(poly_z, z_, 1, &inverse_degree_, &inverse_lead_);
+    }
+}
+
+Formula::Formula(const ASTx& x, const ASTx& y) : input_mode_(XY_INPUT), programs_(2)
+{
+    if (!Compile(x, XY_VARIABLES, &programs_[0]) || !Compile(y, XY_VARIABLES, &programs_[1]))
+    {
+        programs_.clear();
+        return;
+    }
+    compileDerivatives(Derivatives(x, y), XY_VARIABLES);
+
+    // Conjugation turns the signs of y and cy, the x part has to stay and the y part to turn with them
+    conjugate_symmetric_ = (Parity(x, { "y", "cy" }) == EVEN_PARITY) && (Parity(y, { "y", "cy" }) == ODD_PARITY);
+    const size_t parity_x = Parity(x, { "x", "y" });
+    parity_ = (parity_x == Parity(y, { "x", "y" })) ? parity_x : size_t(NO_PARITY);
+
+    // x^2 - y^2 + cx, 2xy + cy
+    Polynomial poly_x;
+    Polynomial poly_y;
+    if (Polynomial::FromAST(x, XY_VARIABLES, &poly_x) && Polynomial::FromAST(y, XY_VARIABLES, &poly_y))
+    {
+        const size_t vars_num = XY_VARIABLES.size();
+        Polynomial x_ = Polynomial::Variable(vars_num, 0);
+        Polynomial y_ = Polynomial::Variable(vars_num, 1);
+        Polynomial cx_ = Polynomial::Variable(vars_num, 2);
+        Polynomial cy_ = Polynomial::Variable(vars_num, 3);
+
+        quadratic_ = poly_x.isApprox(x_ * x_ - y_ * y_ + cx_) && poly_y.isApprox(x_ * y_ * Polynomial::Coefficient(2.0) + cy_);
+
+        // Both parts are taken together as one polynomial in x + iy
+        const Polynomial::Coefficient i(0.0, 1.0);
+        InverseBranches(poly_x + poly_y * i, x_ + y_ * i, 2, &inverse_degree_, &inverse_lead_);
+    }
+}
+
+bool Formula::empty() const
+{
+    return programs_.empty();
+}
+
+bool Formula::hasDerivative() const
+{
+    return derivative_;
+}
+
+size_t Formula::inputMode() const
+{
+    return input_mode_;
+}
+
+bool Formula::isQuadratic() const
+{
+    return quadratic_;
+}
+
+size_t Formula::inverseBranches() const
+{
+    return inverse_degree_;
+}
+
+bool Formula::isConjugateSymmetric() const
+{
+    return conjugate_symmetric_;
+}
+
+size_t Formula::parity() const
+{
+    return parity_;
+}
+
+std::vector<ASTz> Formula::Derivatives(const ASTz& z)
+{
+    std::vector<ASTz> derivatives;
+    for (const std::string& var_name : Z_VARIABLES)
+    {
+        derivatives.push_back(z.derivative(var_name).simplify());
+    }
+    return derivatives;
+}
+
+std::vector<ASTx> Formula::Derivatives(const ASTx& x, const ASTx& y)
+{
+    std::vector<ASTx> derivatives;
+    for (const ASTx* part : { &x, &y })
+    {
+        for (const std::string& var_name : XY_VARIABLES)
+        {
+            derivatives.push_back(part->derivative(var_name).simplify());
+        }
+    }
+    return derivatives;
+}
+
+template <typename T>
+void Formula::compileDerivatives(const std::vector<ast::AST<T>>& derivatives, const std::vector<std::string>& var_names)
+{
+    // Derivatives too deep to compile only leave distance estimation out, the formula itself still renders
+    const size_t parts = programs_.size();
+    programs_.resize(parts + derivatives.size());
+    derivative_ = true;
+    for (size_t i = 0; (i < derivatives.size()) && derivative_; ++i)
+    {
+        derivative_ = Compile(derivatives[i], var_names, &programs_[parts + i]);
+    }
+
+    if (!derivative_)
+    {
+        programs_.resize(parts);
+    }
+}
+
+size_t Formula::fingerprint() const
+{
+    std::string bytes;
+    auto append = [&bytes](const auto& value) { bytes.append(reinterpret_cast<const char*>(&value), sizeof(value)); };
+
+    append(input_mode_);
+    for (const auto& program : programs_)
+    {
+        append(program.code.size());
+        for (const auto& instruction : program.code)
+        {
+            append(instruction.op);
+            append(instruction.arg);
+        }
+        for (const auto& number : program.numbers)
+        {
+            append(number);
+        }
+    }
+    return std::hash<std::string_view>()(bytes);
+}
@@ -0,0 +1,138 @@
+#include "Render/FrameSymmetry.h"
+
+#include <cmath>
+
+namespace {
+
+// Samples i and i' of an axis sit on both sides of zero when i + i' is the returned sum, samples being at
+// origin + extent * (i / aa + 0.5) / size. Only sums whose mirror images overlap the frame are of use
+bool mirrorSum(const DoubleDouble& origin, const DoubleDouble& extent, uint32_t size, int64_t aa, int64_t* sum)
+{
+    const double samples = static_cast<double>(size) * static_cast<double>(aa);
+    const double exact = static_cast<double>(aa) * (-2.0 * static_cast<double>(origin / extent) * static_cast<double>(size) - 1.0);
+    if (!(exact >= 0.0) || !(exact < 2.0 * samples) || (std::abs(exact - std::round(exact)) > SYMMETRY_TOLERANCE))
+    {
+        return false;
+    }
+    *sum = static_cast<int64_t>(std::round(exact));
+    return true;
+}
+
+}
+
+FrameSymmetry::FrameSymmetry(const RenderJob& job) :
+    size_(job.size), layout_(job.layout), aa_(static_cast<int64_t>(job.antialiasing + 1))
+{
+    // Adaptive antialiasing decides on the first sample of a pixel, which mirrors to another sample of another pixel
+    if (job.formula.empty() || (job.size.x == 0) || (job.size.y == 0) || (job.rendering_mode == ORBIT_DENSITY) ||
+        (job.rendering_mode == INVERSE_ITERATION) || (job.adaptive_antialiasing && (job.antialiasing > 0)))
+    {
+        return;
+    }
+
+    // Orbits of mirrored points are conjugate, or the same after the first step for even formulas and opposite for odd
+    // ones. Tracer sums see the first step and Newton steps of both even and odd formulas are odd
+    const size_t parity = ((job.fractal_mode == JULIA) && (job.itrn_max > 0)) ? job.formula.parity() : size_t(NO_PARITY);
+    conjugate_ = job.formula.isConjugateSymmetric() && ((job.fractal_mode == MAIN) || (job.julia_point.y == 0.0F));
+    point_ = !conjugate_ && ((parity == ODD_PARITY) || ((parity == EVEN_PARITY) && (job.rendering_mode != TRACER)));
+    negate_ = point_ && ((parity == ODD_PARITY) || (job.rendering_mode == NEWTON));
+    if ((!conjugate_ && !point_) || !mirrorSum(job.borders.top, -job.borders.height(), job.size.y, aa_, &mirror_sum_[1]) ||
+        (point_ && !mirrorSum(job.borders.left, job.borders.width(), job.size.x, aa_, &mirror_sum_[0])))
+    {
+        return;
+    }
+
+    // Rows all of whose samples are past the axis and mirror into the frame are copied, as are the columns whose samples
+    // mirror into the frame for the origin
+    const int64_t sum_y = mirror_sum_[1];
+    const int64_t row_begin = sum_y / (2 * aa_) + 1;
+    const int64_t row_end = std::min<int64_t>(job.size.y, (sum_y + 1) / aa_);
+
+    int64_t col_begin = 0;
+    int64_t col_end = job.size.x;
+    if (point_)
+    {
+        const int64_t sum_x = mirror_sum_[0];
+        const int64_t samples_x = static_cast<int64_t>(job.size.x) * aa_;
+        col_begin = std::max<int64_t>(0, (sum_x - samples_x + aa_) / aa_);
+        col_end = std::min<int64_t>(job.size.x, (sum_x + 1) / aa_);
+    }
+    if ((row_begin >= row_end) || (col_begin >= col_end))
+    {
+        return;
+    }
+
+    copied_position_ = vec2u(static_cast<uint32_t>(col_begin), static_cast<uint32_t>(row_begin));
+    copied_size_ = vec2u(static_cast<uint32_t>(col_end - col_begin), static_cast<uint32_t>(row_end - row_begin));
+
+    regions_.push_back({ vec2u(), vec2u(job.size.x, copied_position_.y) });
+    if (row_end < job.size.y)
+    {
+        regions_.push_back({ vec2u(0, static_cast<uint32_t>(row_end)), vec2u(job.size.x, job.size.y - static_cast<uint32_t>(row_end)) });
+    }
+    if (col_begin > 0)
+    {
+        regions_.push_back({ vec2u(0, copied_position_.y), vec2u(copied_position_.x, copied_size_.y) });
+    }
+    if (col_end < job.size.x)
+    {
+        regions_.push_back({ vec2u(static_cast<uint32_t>(col_end), copied_position_.y), vec2u(job.size.x - static_cast<uint32_t>(col_end), copied_size_.y) });
+    }
+}
+
+bool FrameSymmetry::empty() const
+{
+    return regions_.empty();
+}
+
+const std::vector<RenderRegion>& FrameSymmetry::regions() const
+{
+    return regions_;
+}
+
+bool FrameSymmetry::mirrored() const
+{
+    return conjugate_ || point_;
+}
+
+bool FrameSymmetry::pointSymmetric() const
+{
+    return point_;
+}
+
+SampleData FrameSymmetry::mirror(const SampleData& sample) const
+{
+    SampleData mirrored = sample;
+    if (conjugate_)
+    {
+        mirrored.z = std::conj(mirrored.z);
+    }
+    if (negate_)
+    {
+        mirrored.z = -mirrored.z;
+    }
+    return mirrored;
+}
+
+void FrameSymmetry::fill(SampleData* data) const
+{
+    const SampleLayout layout(size_, layout_);
+    const int64_t samples_num = aa_ * aa_;
+    for (uint32_t row = copied_position_.y; row < copied_position_.y + copied_size_.y; ++row)
+    {
+        for (uint32_t col = copied_position_.x; col < copied_position_.x + copied_size_.x; ++col)
+        {
+            SampleData* samples = data + static_cast<int64_t>(layout(col, row)) * samples_num;
+            for (int64_t k = 0; k < samples_num; ++k)
+            {
+                const int64_t x = static_cast<int64_t>(col) * aa_ + k / aa_;
+                const int64_t y = static_cast<int64_t>(row) * aa_ + k % aa_;
+                const int64_t mirror_x = point_ ? mirror_sum_[0] - x : x;
+                const int64_t mirror_y = mirror_sum_[1] - y;
+
+                const size_t pixel = layout(static_cast<uint32_t>(mirror_x / aa_), static_cast<uint32_t>(mirror_y / aa_));
+                samples[k] = mirror(data[pixel * static_cast<size_t>(samples_num) + static_cast<size_t>((mirror_x % aa_) * aa_ + mirror_y % aa_)]);
+            }
+        }
+    }
+}
@@ -0,0 +1,160 @@
+#include "Render/InverseIteration.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+InverseIteration::InverseIteration(const RenderJob& job) : job_(job)
+{
+    const uint32_t aa = static_cast<uint32_t>(job.antialiasing + 1);
+    bins_ = vec2u(job.size.x * aa, job.size.y * aa);
+    if (!Supports(job))
+    {
+        return;
+    }
+
+    radius_ = Radius(job);
+    grid_size_ = static_cast<uint32_t>(std::max(GridSize(job, radius_), 1.0));
+}
+
+bool InverseIteration::Supports(const RenderJob& job)
+{
+    if ((job.fractal_mode != JULIA) || (job.formula.inverseBranches() == 0) || (job.size.x == 0))
+    {
+        return false;
+    }
+
+    const double grid_size = GridSize(job, Radius(job));
+    return std::isfinite(grid_size) && (grid_size <= static_cast<double>(INVERSE_GRID_SIZE));
+}
+
+double InverseIteration::Radius(const RenderJob& job)
+{
+    // |a z^n + g| > |z| past max(1, ((1 + |g|) / |a|)^(1 / (n - 1))), nothing out there is a preimage of the set
+    const std::complex<double> c(job.julia_point.x, job.julia_point.y);
+    const double g = std::abs(job.formula(std::complex<double>(), c));
+    const double a = std::abs(job.formula(std::complex<double>(1.0), c) - job.formula(std::complex<double>(), c));
+    const double n = static_cast<double>(job.formula.inverseBranches());
+    return std::max(1.0, std::pow((1.0 + g) / a, 1.0 / (n - 1.0)));
+}
+
+double InverseIteration::GridSize(const RenderJob& job, double radius)
+{
+    // Cells of the view across the disk holding the set
+    const double view_cell = static_cast<double>(job.borders.width()) / static_cast<double>(job.size.x * (job.antialiasing + 1));
+    return std::ceil(2.0 * radius / view_cell);
+}
+
+bool InverseIteration::render(const Renderer& renderer, SampleData* data, RenderStats* stats) const
+{
+    using Clock = std::chrono::steady_clock;
+    const Clock::time_point start = Clock::now();
+
+    const uint32_t aa = static_cast<uint32_t>(job_.antialiasing + 1);
+    const SampleLayout layout(job_.size, job_.layout);
+    auto sample = [&](uint32_t x, uint32_t y) -> SampleData& { return data[layout(x / aa, y / aa) * aa * aa + (x % aa) * aa + y % aa]; };
+    for (uint32_t y = 0; y < bins_.y; ++y)
+    {
+        for (uint32_t x = 0; x < bins_.x; ++x)
+        {
+            sample(x, y) = { static_cast<uint32_t>(job_.itrn_max), {}, {} };
+        }
+    }
+
+    const size_t branches = job_.formula.inverseBranches();
+    if ((branches == 0) || (job_.itrn_max == 0) || !std::isfinite(radius_))
+    {
+        return true;
+    }
+
+    const double left = static_cast<double>(job_.borders.left);
+    const double top = static_cast<double>(job_.borders.top);
+    const double scale_x = static_cast<double>(bins_.x) / static_cast<double>(job_.borders.width());
+    const double scale_y = static_cast<double>(bins_.y) / static_cast<double>(job_.borders.height());
+    const double grid_scale = static_cast<double>(grid_size_) / (2.0 * radius_);
+    std::vector<uint8_t> view_hits(static_cast<size_t>(bins_.x) * bins_.y);
+    std::vector<uint8_t> grid_hits(static_cast<size_t>(grid_size_) * grid_size_);
+
+    // Cell of a point counts one more hit, false once it has had enough of them
+    auto visit = [&](const std::complex<double>& z, size_t depth)
+    {
+        const double bin_x = (z.real() - left) * scale_x;
+        const double bin_y = (top - z.imag()) * scale_y;
+        if ((bin_x >= 0.0) && (bin_y >= 0.0) && (bin_x < static_cast<double>(bins_.x)) && (bin_y < static_cast<double>(bins_.y)))
+        {
+            const uint32_t x = static_cast<uint32_t>(bin_x);
+            const uint32_t y = static_cast<uint32_t>(bin_y);
+            uint8_t& hits = view_hits[static_cast<size_t>(y) * bins_.x + x];
+            if (hits >= INVERSE_CELL_HITS)
+            {
+                return false;
+            }
+            if (hits++ == 0)
+            {
+                sample(x, y) = { static_cast<uint32_t>(depth), std::complex<float>(z), {} };
+            }
+            return true;
+        }
+
+        const double cell_x = (z.real() + radius_) * grid_scale;
+        const double cell_y = (radius_ - z.imag()) * grid_scale;
+        if (!(cell_x >= 0.0) || !(cell_y >= 0.0) || !(cell_x < static_cast<double>(grid_size_)) || !(cell_y < static_cast<double>(grid_size_)))
+        {
+            return false;
+        }
+        uint8_t& hits = grid_hits[static_cast<size_t>(cell_y) * grid_size_ + static_cast<size_t>(cell_x)];
+        if (hits >= INVERSE_CELL_HITS)
+        {
+            return false;
+        }
+        ++hits;
+        return true;
+    };
+
+    // Repeated preimages by one branch settle on a repelling fixed point of the formula, which is in the set
+    const std::complex<double> c(job_.julia_point.x, job_.julia_point.y);
+    std::vector<std::complex<double>> preimages(branches);
+    std::complex<double> z = 1.0;
+    for (size_t n = 0; n < INVERSE_WARMUP; ++n)
+    {
+        job_.formula.inverse(z, c, preimages.data());
+        z = preimages[0];
+    }
+
+    struct Point final
+    {
+        std::complex<double> z;
+        size_t depth;
+    };
+    std::vector<Point> stack = { { z, 0 } };
+    size_t visited = 0;
+    while (!stack.empty())
+    {
+        const Point point = stack.back();
+        stack.pop_back();
+        if ((++visited % INVERSE_CANCEL_CHECK == 0) && renderer.cancelled())
+        {
+            return false;
+        }
+        if (!visit(point.z, point.depth) || (point.depth + 1 >= job_.itrn_max))
+        {
+            continue;
+        }
+
+        job_.formula.inverse(point.z, c, preimages.data());
+        for (const std::complex<double>& preimage : preimages)
+        {
+            stack.push_back({ preimage, point.depth + 1 });
+        }
+    }
+
+    if (stats != nullptr)
+    {
+        stats->pixels = static_cast<size_t>(job_.size.x) * job_.size.y;
+        stats->promoted = 0;
+        stats->refined = 0;
+        stats->time = std::chrono::duration<double>(Clock::now() - start).count();
+        stats->tail = 0.0;
+    }
+    return true;
+}
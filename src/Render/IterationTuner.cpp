@@ -0,0 +1,72 @@
+#include "Render/IterationTuner.h"
+
+#include <algorithm>
+
+// Escapes in the last quarter of the limit that mean false interior is likely
+constexpr size_t LATE_BINS = ESCAPE_HISTOGRAM_BINS / 4;
+constexpr double RAISE_FRACTION = 0.01;
+// Quantile of the escape counts kept below half of a lowered limit
+constexpr double LOWER_QUANTILE = 0.999;
+
+EscapeHistogram::EscapeHistogram(const SampleData* data, size_t count, size_t itrn_max) : samples(count), itrn_max(itrn_max)
+{
+    for (size_t i = 0; i < count; ++i)
+    {
+        if (data[i].itrn >= itrn_max)
+        {
+            ++interior;
+        }
+        else
+        {
+            ++bins[data[i].itrn * ESCAPE_HISTOGRAM_BINS / itrn_max];
+        }
+    }
+}
+
+size_t IterationTuner::tune(const EscapeHistogram& histogram)
+{
+    const size_t itrn_max = histogram.itrn_max;
+    const size_t raised = std::min(itrn_max * 2, std::max(MAX_AUTO_ITERATION, itrn_max));
+    const size_t escaped = histogram.samples - histogram.interior;
+    if ((histogram.samples == 0) || (itrn_max == 0))
+    {
+        return itrn_max;
+    }
+
+    // Nothing escaping is either real interior or a view deeper than the limit, only a few raises are tried
+    if (escaped == 0)
+    {
+        return (blind_raises_ < MAX_BLIND_RAISES) ? (++blind_raises_, raised) : itrn_max;
+    }
+    blind_raises_ = 0;
+
+    size_t late = 0;
+    for (size_t bin = ESCAPE_HISTOGRAM_BINS - LATE_BINS; bin < ESCAPE_HISTOGRAM_BINS; ++bin)
+    {
+        late += histogram.bins[bin];
+    }
+
+    // Raising doubles the limit, lowering leaves the escapes in its first half, so neither undoes the other
+    if (static_cast<double>(late) > RAISE_FRACTION * static_cast<double>(histogram.samples))
+    {
+        return raised;
+    }
+    if (late != 0)
+    {
+        return itrn_max;
+    }
+
+    size_t count = 0;
+    size_t bin = 0;
+    while (static_cast<double>(count + histogram.bins[bin]) < LOWER_QUANTILE * static_cast<double>(escaped))
+    {
+        count += histogram.bins[bin++];
+    }
+
+    size_t quantile = (bin + 1) * itrn_max / ESCAPE_HISTOGRAM_BINS;
+    if (quantile * 4 <= itrn_max)
+    {
+        return std::max(quantile * 2, std::min(MIN_AUTO_ITERATION, itrn_max));
+    }
+    return itrn_max;
+}
@@ -0,0 +1,163 @@
+#include "Render/JuliaAtlas.h"
+#include "Render/PngStream.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+JuliaAtlas::JuliaAtlas(const RenderJob& job, uint32_t tile_size) : job_(job)
+{
+    // Tiles stretch by less than half of their size to fill the image
+    auto tiles = [tile_size](uint32_t size)
+    {
+        return std::max<uint32_t>(static_cast<uint32_t>(std::lround(static_cast<double>(size) / static_cast<double>(std::max(tile_size, 1U)))), 1);
+    };
+    tiles_ = vec2u(std::min(tiles(job.size.x), job.size.x), std::min(tiles(job.size.y), job.size.y));
+}
+
+vec2u JuliaAtlas::tiles() const
+{
+    return tiles_;
+}
+
+vec2u JuliaAtlas::tileAt(const vec2u& pixel) const
+{
+    // Last tile starting at or before the pixel, the inverse of tilePosition
+    auto tile = [](uint32_t pixel, uint32_t size, uint32_t tiles)
+    {
+        const uint64_t clamped = std::min(pixel, size - 1);
+        return static_cast<uint32_t>(((clamped + 1) * tiles - 1) / size);
+    };
+    return vec2u(tile(pixel.x, job_.size.x, tiles_.x), tile(pixel.y, job_.size.y, tiles_.y));
+}
+
+vec2f JuliaAtlas::juliaPoint(const vec2u& tile) const
+{
+    const double x = static_cast<double>(job_.borders.left) + static_cast<double>(job_.borders.width()) * (tile.x + 0.5) / tiles_.x;
+    const double y = static_cast<double>(job_.borders.top) - static_cast<double>(job_.borders.height()) * (tile.y + 0.5) / tiles_.y;
+    return vec2f(static_cast<float>(x), static_cast<float>(y));
+}
+
+vec2u JuliaAtlas::tilePosition(uint32_t col, uint32_t row) const
+{
+    return vec2u(static_cast<uint32_t>(static_cast<uint64_t>(col) * job_.size.x / tiles_.x),
+                 static_cast<uint32_t>(static_cast<uint64_t>(row) * job_.size.y / tiles_.y));
+}
+
+bool JuliaAtlas::render(const Renderer& renderer, uint8_t* pixels, RenderStats* stats) const
+{
+    if ((job_.size.x == 0) || (job_.size.y == 0) || job_.formula.empty())
+    {
+        return false;
+    }
+
+    // Thumbnails are never deep, and orbit densities would probe the plane again for every tile
+    RenderJob tile_job = job_;
+    tile_job.fractal_mode = JULIA;
+    tile_job.deep_zoom = false;
+    tile_job.rendering_mode = (job_.rendering_mode == ORBIT_DENSITY) ? size_t(DEFAULT) : job_.rendering_mode;
+
+    const size_t tiles_num = static_cast<size_t>(tiles_.x) * tiles_.y;
+    const size_t threads_num = std::min(renderer.threadsNum(), tiles_num);
+    std::atomic<size_t> next_tile = 0;
+    std::mutex stats_mutex;
+    RenderStats total;
+
+    using Clock = std::chrono::steady_clock;
+    const Clock::time_point start = Clock::now();
+    std::vector<Clock::time_point> finish(threads_num);
+    auto run_tiles = [&](size_t thread_ind)
+    {
+        // Rows of one small tile are not worth scheduling, neither are costs of Julia sets seen once
+        Renderer tile_renderer(1);
+        tile_renderer.setCostPrediction(false);
+        RenderJob job = tile_job;
+        std::vector<SampleData> data;
+        std::vector<uint8_t> tile_pixels;
+
+        for (size_t tile = next_tile++; (tile < tiles_num) && !renderer.cancelled(); tile = next_tile++)
+        {
+            const uint32_t col = static_cast<uint32_t>(tile % tiles_.x);
+            const uint32_t row = static_cast<uint32_t>(tile / tiles_.x);
+            const vec2u position = tilePosition(col, row);
+            const vec2u end = tilePosition(col + 1, row + 1);
+
+            // Shorter side of a tile spans the disk most Julia sets fit in
+            job.size = vec2u(end.x - position.x, end.y - position.y);
+            job.julia_point = juliaPoint(vec2u(col, row));
+            const double scale = ATLAS_RADIUS / static_cast<double>(std::min(job.size.x, job.size.y));
+            const double half_width = scale * static_cast<double>(job.size.x);
+            const double half_height = scale * static_cast<double>(job.size.y);
+            job.borders = Borders2D<DoubleDouble>(-half_width, half_width, -half_height, half_height);
+
+            RenderStats tile_stats;
+            data.resize(Renderer::SamplesNum(job));
+            tile_pixels.resize(static_cast<size_t>(job.size.x) * job.size.y * 4);
+            tile_renderer.render(job, data.data(), &tile_stats);
+            Renderer::Colorize(job, data.data(), tile_pixels.data());
+
+            for (uint32_t y = 0; y < job.size.y; ++y)
+            {
+                std::copy_n(tile_pixels.data() + static_cast<size_t>(y) * job.size.x * 4, static_cast<size_t>(job.size.x) * 4,
+                            pixels + ((static_cast<size_t>(position.y) + y) * job_.size.x + position.x) * 4);
+            }
+
+            std::lock_guard<std::mutex> lock(stats_mutex);
+            total.pixels += tile_stats.pixels;
+            total.promoted += tile_stats.promoted;
+            total.refined += tile_stats.refined;
+        }
+        finish[thread_ind] = Clock::now();
+    };
+
+    std::vector<std::thread> threads;
+    for (size_t i = 1; i < threads_num; ++i)
+    {
+        threads.emplace_back(run_tiles, i);
+    }
+    run_tiles(0);
+
+    for (std::thread& thread : threads)
+    {
+        thread.join();
+    }
+    if (renderer.cancelled())
+    {
+        return false;
+    }
+
+    if (stats != nullptr)
+    {
+        auto [first, last] = std::minmax_element(finish.begin(), finish.end());
+        total.time = std::chrono::duration<double>(*last - start).count();
+        total.tail = std::chrono::duration<double>(*last - *first).count();
+        *stats = total;
+    }
+    return true;
+}
+
+bool JuliaAtlas::save(const Renderer& renderer, const std::string& filename, RenderStats* stats) const
+{
+    std::vector<uint8_t> pixels(static_cast<size_t>(job_.size.x) * job_.size.y * 4);
+    if (!render(renderer, pixels.data(), stats))
+    {
+        return false;
+    }
+
+    PngStream stream(filename, job_.size.x, job_.size.y);
+    if (!stream.good())
+    {
+        return false;
+    }
+
+    std::vector<uint8_t> row(static_cast<size_t>(job_.size.x) * 3);
+    for (uint32_t y = 0; y < job_.size.y; ++y)
+    {
+        for (uint32_t x = 0; x < job_.size.x; ++x)
+        {
+            std::copy_n(pixels.data() + (static_cast<size_t>(y) * job_.size.x + x) * 4, 3, row.data() + static_cast<size_t>(x) * 3);
+        }
+        stream.writeRows(row.data(), 1);
+    }
+    return stream.good();
+}
@@ -0,0 +1,267 @@
+#include "Render/OrbitDensity.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <random>
+
+// Cells whose whole neighbourhood stays bounded still get a few samples, small escaping islands are not lost
+constexpr double MIN_CELL_IMPORTANCE = 1.0;
+
+OrbitDensity::OrbitDensity(const RenderJob& job) : job_(job)
+{
+    // Samples of a pixel share bins once the bins of all of them would be too many
+    const size_t pixels = static_cast<size_t>(job.size.x) * job.size.y;
+    uint32_t aa = static_cast<uint32_t>(job.antialiasing + 1);
+    while ((aa > 1) && (pixels * aa * aa > DENSITY_MAX_BINS))
+    {
+        --aa;
+    }
+    bin_aa_ = aa;
+    bins_ = vec2u(job.size.x * aa, job.size.y * aa);
+
+    // Orbit points per bin stay about the same whatever part of the plane is in view, up to the oversampling limit
+    const double view_area = static_cast<double>(job.borders.width()) * static_cast<double>(job.borders.height());
+    const double oversampling = std::clamp(DENSITY_REFERENCE_AREA / view_area, 1.0 / DENSITY_MAX_OVERSAMPLING, DENSITY_MAX_OVERSAMPLING);
+    samples_ = static_cast<size_t>(std::ceil(static_cast<double>(bins_.x) * static_cast<double>(bins_.y) * DENSITY_SAMPLES_PER_PIXEL * oversampling));
+
+    // All escaping orbits go to the first range, the ones shorter than itrn_max^(2/3) and itrn_max^(1/3) to the next two
+    const double root = std::cbrt(static_cast<double>(job.itrn_max));
+    band_itrn_[0] = static_cast<size_t>(std::ceil(root * root));
+    band_itrn_[1] = static_cast<size_t>(std::ceil(root));
+}
+
+size_t OrbitDensity::samples() const
+{
+    return samples_;
+}
+
+bool OrbitDensity::render(const Renderer& renderer, SampleData* data, RenderStats* stats)
+{
+    probe(renderer);
+    if (renderer.cancelled())
+    {
+        return false;
+    }
+
+    const size_t bins_num = static_cast<size_t>(bins_.x) * bins_.y;
+    const size_t histogram_size = bins_num * 3 * sizeof(float);
+    const size_t threads_num = std::clamp(DENSITY_MEMORY_BUDGET / histogram_size, size_t(1), renderer.threadsNum());
+    auto parallel = [threads_num](const auto& function)
+    {
+        std::vector<std::thread> threads;
+        for (size_t i = 1; i < threads_num; ++i)
+        {
+            threads.emplace_back(function, i);
+        }
+        function(0);
+
+        for (auto& thread : threads)
+        {
+            thread.join();
+        }
+    };
+
+    auto formula_step = [this]<typename T>(const std::complex<T>& z, const std::complex<T>& c) { return job_.formula(z, c); };
+    auto quadratic_step = []<typename T>(const std::complex<T>& z, const std::complex<T>& c)
+    {
+        return std::complex<T>(z.real() * z.real() - z.imag() * z.imag() + c.real(), T(2.0) * z.real() * z.imag() + c.imag());
+    };
+
+    // Threads take batches of samples and count their orbits into their own histogram, no bin is shared while counting
+    const size_t batches = (samples_ + DENSITY_BATCH_SIZE - 1) / DENSITY_BATCH_SIZE;
+    std::vector<std::vector<float>> histograms(threads_num);
+    std::atomic<size_t> next_batch = 0;
+
+    using Clock = std::chrono::steady_clock;
+    const Clock::time_point start = Clock::now();
+    std::vector<Clock::time_point> finish(threads_num);
+    parallel([&](size_t thread_ind)
+    {
+        std::vector<float>& histogram = histograms[thread_ind];
+        histogram.resize(bins_num * 3);
+        std::vector<std::complex<float>> float_orbit;
+        std::vector<std::complex<double>> double_orbit;
+
+        auto accumulate_batch = [&](auto* orbit, size_t batch)
+        {
+            if (job_.formula.isQuadratic())
+            {
+                accumulate(quadratic_step, batch, orbit, histogram.data());
+                return;
+            }
+            accumulate(formula_step, batch, orbit, histogram.data());
+        };
+
+        for (size_t batch = next_batch++; (batch < batches) && !renderer.cancelled(); batch = next_batch++)
+        {
+            if (job_.precision == SINGLE_PRECISION)
+            {
+                accumulate_batch(&float_orbit, batch);
+                continue;
+            }
+            accumulate_batch(&double_orbit, batch);
+        }
+        finish[thread_ind] = Clock::now();
+    });
+    if (renderer.cancelled())
+    {
+        return false;
+    }
+
+    // Counts become densities against orbit points spread evenly over the sampled square, one per sample
+    const double sample_area = 4.0 * DENSITY_SAMPLE_RADIUS * DENSITY_SAMPLE_RADIUS;
+    const double bin_area = static_cast<double>(job_.borders.width()) * static_cast<double>(job_.borders.height()) / static_cast<double>(bins_num);
+    const double scale = sample_area / (static_cast<double>(samples_) * bin_area);
+
+    const uint32_t aa = static_cast<uint32_t>(job_.antialiasing + 1);
+    const SampleLayout layout(job_.size, job_.layout);
+    std::atomic<uint32_t> next_row = 0;
+    parallel([&](size_t)
+    {
+        for (uint32_t row = next_row++; row < job_.size.y * aa; row = next_row++)
+        {
+            const uint32_t bin_row = row / aa * bin_aa_ + row % aa * bin_aa_ / aa;
+            for (uint32_t col = 0; col < job_.size.x * aa; ++col)
+            {
+                const uint32_t bin_col = col / aa * bin_aa_ + col % aa * bin_aa_ / aa;
+                const size_t bin = (static_cast<size_t>(bin_row) * bins_.x + bin_col) * 3;
+                double density[3] = {};
+                for (const std::vector<float>& histogram : histograms)
+                {
+                    density[0] += histogram[bin];
+                    density[1] += histogram[bin + 1];
+                    density[2] += histogram[bin + 2];
+                }
+
+                SampleData& sample = data[layout(col / aa, row / aa) * aa * aa + (col % aa) * aa + row % aa];
+                sample = { 0, {}, { static_cast<float>(density[0] * scale), static_cast<float>(density[1] * scale), static_cast<float>(density[2] * scale) } };
+            }
+        }
+    });
+
+    if (stats != nullptr)
+    {
+        auto [first, last] = std::minmax_element(finish.begin(), finish.end());
+        stats->pixels = static_cast<size_t>(job_.size.x) * job_.size.y;
+        stats->promoted = 0;
+        stats->refined = 0;
+        stats->time = std::chrono::duration<double>(*last - start).count();
+        stats->tail = std::chrono::duration<double>(*last - *first).count();
+    }
+    return true;
+}
+
+void OrbitDensity::probe(const Renderer& renderer)
+{
+    RenderJob probe_job = job_;
+    probe_job.rendering_mode = DEFAULT;
+    probe_job.antialiasing = 0;
+    probe_job.adaptive_antialiasing = false;
+    probe_job.deep_zoom = false;
+    probe_job.layout = LINEAR_LAYOUT;
+    probe_job.size = vec2u(DENSITY_PROBE_SIZE, DENSITY_PROBE_SIZE);
+    probe_job.borders = Borders2D<DoubleDouble>(-DENSITY_SAMPLE_RADIUS, DENSITY_SAMPLE_RADIUS, -DENSITY_SAMPLE_RADIUS, DENSITY_SAMPLE_RADIUS);
+
+    std::vector<SampleData> probe(static_cast<size_t>(DENSITY_PROBE_SIZE) * DENSITY_PROBE_SIZE);
+    renderer.render(probe_job, probe.data());
+
+    // A cell is worth the longest escape time around it, the longest orbits start close to the boundary
+    auto escape_time = [&](int64_t x, int64_t y)
+    {
+        if ((x < 0) || (y < 0) || (x >= DENSITY_PROBE_SIZE) || (y >= DENSITY_PROBE_SIZE))
+        {
+            return 0.0;
+        }
+        uint32_t itrn = probe[static_cast<size_t>(y) * DENSITY_PROBE_SIZE + static_cast<size_t>(x)].itrn;
+        return (itrn < job_.itrn_max) ? static_cast<double>(itrn) : 0.0;
+    };
+
+    cell_cdf_.resize(probe.size());
+    double total = 0.0;
+    for (int64_t y = 0; y < DENSITY_PROBE_SIZE; ++y)
+    {
+        for (int64_t x = 0; x < DENSITY_PROBE_SIZE; ++x)
+        {
+            double importance = 0.0;
+            for (int64_t dy = -1; dy <= 1; ++dy)
+            {
+                for (int64_t dx = -1; dx <= 1; ++dx)
+                {
+                    importance = std::max(importance, escape_time(x + dx, y + dy));
+                }
+            }
+            total += MIN_CELL_IMPORTANCE + importance;
+            cell_cdf_[static_cast<size_t>(y) * DENSITY_PROBE_SIZE + static_cast<size_t>(x)] = total;
+        }
+    }
+}
+
+template <typename T, typename Step>
+void OrbitDensity::accumulate(const Step& step, size_t batch, std::vector<std::complex<T>>* orbit, float* histogram) const
+{
+    const double cell_size = 2.0 * DENSITY_SAMPLE_RADIUS / DENSITY_PROBE_SIZE;
+    const double total = cell_cdf_.back();
+    const double cells = static_cast<double>(cell_cdf_.size());
+    const double left = static_cast<double>(job_.borders.left);
+    const double top = static_cast<double>(job_.borders.top);
+    const double scale_x = static_cast<double>(bins_.x) / static_cast<double>(job_.borders.width());
+    const double scale_y = static_cast<double>(bins_.y) / static_cast<double>(job_.borders.height());
+    const T limit = static_cast<T>(job_.limit) * static_cast<T>(job_.limit);
+    const bool interior_check = job_.formula.isQuadratic() && (job_.fractal_mode == MAIN);
+    const std::complex<T> julia_point(job_.julia_point.x, job_.julia_point.y);
+    orbit->resize(job_.itrn_max);
+
+    // Every batch has a generator of its own, the samples do not depend on the number of threads
+    std::mt19937_64 generator(batch);
+    std::uniform_real_distribution<double> uniform(0.0, 1.0);
+
+    const size_t end = std::min((batch + 1) * DENSITY_BATCH_SIZE, samples_);
+    for (size_t i = batch * DENSITY_BATCH_SIZE; i < end; ++i)
+    {
+        // Cells are drawn by importance and weighted back, so the densities are those of uniform sampling
+        const size_t cell = std::min(static_cast<size_t>(std::upper_bound(cell_cdf_.begin(), cell_cdf_.end(), uniform(generator) * total) -
+                                                         cell_cdf_.begin()), cell_cdf_.size() - 1);
+        const double importance = cell_cdf_[cell] - ((cell == 0) ? 0.0 : cell_cdf_[cell - 1]);
+        const float weight = static_cast<float>(total / (cells * importance));
+
+        const double x = -DENSITY_SAMPLE_RADIUS + (static_cast<double>(cell % DENSITY_PROBE_SIZE) + uniform(generator)) * cell_size;
+        const double y = DENSITY_SAMPLE_RADIUS - (static_cast<double>(cell / DENSITY_PROBE_SIZE) + uniform(generator)) * cell_size;
+        if (interior_check && InsideQuadraticInterior(x, y))
+        {
+            continue;
+        }
+
+        std::complex<T> z(static_cast<T>(x), static_cast<T>(y));
+        const std::complex<T> c = (job_.fractal_mode == MAIN) ? z : julia_point;
+        size_t itrn = 0;
+        for (; itrn < job_.itrn_max; ++itrn)
+        {
+            z = step(z, c);
+            if (std::norm(z) > limit)
+            {
+                break;
+            }
+            (*orbit)[itrn] = z;
+        }
+        if (itrn == job_.itrn_max)
+        {
+            continue;
+        }
+
+        const size_t ranges = (itrn < band_itrn_[1]) ? 3 : ((itrn < band_itrn_[0]) ? 2 : 1);
+        for (size_t n = 0; n < itrn; ++n)
+        {
+            const double bin_x = (static_cast<double>((*orbit)[n].real()) - left) * scale_x;
+            const double bin_y = (top - static_cast<double>((*orbit)[n].imag())) * scale_y;
+            if ((bin_x >= 0.0) && (bin_y >= 0.0) && (bin_x < static_cast<double>(bins_.x)) && (bin_y < static_cast<double>(bins_.y)))
+            {
+                float* bin = histogram + (static_cast<size_t>(bin_y) * bins_.x + static_cast<size_t>(bin_x)) * 3;
+                for (size_t k = 0; k < ranges; ++k)
+                {
+                    bin[k] += weight;
+                }
+            }
+        }
+    }
+}
@@ -0,0 +1,82 @@
+#include "Render/Palette.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+constexpr float PI = 3.14159265358979F;
+
+inline float pf(float x)
+{
+    constexpr float K = PI / 3.0F;
+    return std::min(std::max(std::acos(std::cos(x * K)) / K - 1.0F, 0.0F), 1.0F);
+}
+
+inline float saturate(float x)
+{
+    return std::clamp(x, 0.0F, 1.0F);
+}
+
+} // namespace
+
+Palette::Palette(size_t type) : type_(type), colors_(PALETTE_SIZE)
+{
+    for (size_t i = 0; i < PALETTE_SIZE; ++i)
+    {
+        // Ramps go up and back down so that the table wraps around without a seam
+        float x = static_cast<float>(i) * 4.0F / 255.0F;
+        float t = static_cast<float>(i) / static_cast<float>(PALETTE_SIZE);
+        float s = 1.0F - std::abs(2.0F * t - 1.0F);
+
+        switch (type)
+        {
+        case FIRE_PALETTE:
+        {
+            colors_[i] = { saturate(3.0F * s), saturate(3.0F * s - 1.0F), saturate(3.0F * s - 2.0F) };
+            break;
+        }
+        case OCEAN_PALETTE:
+        {
+            colors_[i] = { saturate(3.0F * s - 2.0F), saturate(1.5F * s), saturate(0.3F + s) };
+            break;
+        }
+        case GRAYSCALE_PALETTE:
+        {
+            colors_[i] = { s, s, s };
+            break;
+        }
+        default:
+        {
+            colors_[i] = { pf(x - 3.0F), pf(x - 5.0F), pf(x - 7.0F) };
+            break;
+        }
+        }
+    }
+}
+
+const Color& Palette::operator[](size_t itrn) const
+{
+    return colors_[itrn % PALETTE_SIZE];
+}
+
+size_t Palette::type() const
+{
+    return type_;
+}
+
+std::vector<uint8_t> Palette::toRGBA() const
+{
+    std::vector<uint8_t> rgba;
+    rgba.reserve(PALETTE_SIZE * 4);
+    for (const auto& color : colors_)
+    {
+        rgba.insert(rgba.end(), { ToByte(color.r), ToByte(color.g), ToByte(color.b), 255 });
+    }
+    return rgba;
+}
+
+uint8_t ToByte(float channel)
+{
+    return static_cast<uint8_t>(std::clamp(channel, 0.0F, 1.0F) * 255.0F + 0.5F);
+}
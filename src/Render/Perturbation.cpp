@@ -0,0 +1,140 @@
+#include "Render/Perturbation.h"
+
+#include <algorithm>
+
+// Relative size of the dz^2 term that an approximation is allowed to drop
+constexpr double BLA_EPSILON = 1.0 / (1ULL << 40);
+
+ReferenceOrbit::ReferenceOrbit(const vec2dd& c, size_t itrn_max, double limit) : center_(c)
+{
+    DoubleDouble x;
+    DoubleDouble y;
+    orbit_.emplace_back();
+
+    for (size_t n = 0; n <= itrn_max; ++n)
+    {
+        DoubleDouble x2 = x * x;
+        DoubleDouble y2 = y * y;
+        y = (x + x) * y + c.y;
+        x = x2 - y2 + c.x;
+
+        orbit_.emplace_back(static_cast<double>(x), static_cast<double>(y));
+        if (std::norm(orbit_.back()) > limit * limit)
+        {
+            break;
+        }
+    }
+}
+
+const vec2dd& ReferenceOrbit::center() const
+{
+    return center_;
+}
+
+size_t ReferenceOrbit::size() const
+{
+    return orbit_.size();
+}
+
+const std::complex<double>& ReferenceOrbit::operator[](size_t n) const
+{
+    return orbit_[n];
+}
+
+Perturbation::Perturbation(const vec2dd& center, size_t itrn_max, double limit, double dc_max) :
+    reference_(center, itrn_max, limit), itrn_max_(itrn_max), limit_(limit)
+{
+    // Single steps dz -> 2 Z dz + dc, valid while dz^2 is negligible
+    std::vector<Approximation> level;
+    for (size_t m = 1; m + 1 < reference_.size(); ++m)
+    {
+        std::complex<double> a = 2.0 * reference_[m];
+        level.push_back({ a, 1.0, BLA_EPSILON * std::abs(a) });
+    }
+
+    // Merge neighbouring steps into blocks of 2^k steps
+    while (level.size() > 1)
+    {
+        std::vector<Approximation> merged;
+        for (size_t j = 0; j + 1 < level.size(); j += 2)
+        {
+            const Approximation& x = level[j];
+            const Approximation& y = level[j + 1];
+
+            double ax = std::abs(x.a);
+            double r = (ax == 0.0) ? 0.0 : std::min(x.r, std::max(0.0, (y.r - std::abs(x.b) * dc_max) / ax));
+            merged.push_back({ y.a * x.a, y.a * x.b + y.b, r });
+        }
+        levels_.emplace_back(std::move(level));
+        level = std::move(merged);
+    }
+    levels_.emplace_back(std::move(level));
+}
+
+size_t Perturbation::iterate(const std::complex<double>& dc) const
+{
+    const size_t last = reference_.size() - 1;
+    const double limit2 = limit_ * limit_;
+
+    std::complex<double> dz;
+    size_t m = 0;
+    size_t n = 0;
+
+    while (n <= itrn_max_)
+    {
+        size_t steps = 1;
+        const Approximation* approx = (m > 0) ? lookup(m, std::norm(dz), itrn_max_ + 1 - n, &steps) : nullptr;
+
+        if (approx != nullptr)
+        {
+            dz = approx->a * dz + approx->b * dc;
+        }
+        else
+        {
+            dz = (2.0 * reference_[m] + dz) * dz + dc;
+        }
+        m += steps;
+        n += steps;
+
+        std::complex<double> z = reference_[m] + dz;
+        double z_norm = std::norm(z);
+        if ((n >= 2) && (z_norm > limit2))
+        {
+            return n - 2;
+        }
+
+        // Glitch or end of the reference orbit: continue from its start
+        if ((z_norm < std::norm(dz)) || (m == last))
+        {
+            dz = z;
+            m = 0;
+        }
+    }
+
+    return itrn_max_;
+}
+
+const ReferenceOrbit& Perturbation::reference() const
+{
+    return reference_;
+}
+
+const Perturbation::Approximation* Perturbation::lookup(size_t m, double dz_norm, size_t max_steps, size_t* steps) const
+{
+    for (size_t k = levels_.size() - 1; k > 0; --k)
+    {
+        size_t length = size_t(1) << k;
+        if ((length > max_steps) || (((m - 1) & (length - 1)) != 0))
+        {
+            continue;
+        }
+
+        size_t j = (m - 1) >> k;
+        if ((j < levels_[k].size()) && (dz_norm < levels_[k][j].r * levels_[k][j].r))
+        {
+            *steps = length;
+            return &levels_[k][j];
+        }
+    }
+    return nullptr;
+}
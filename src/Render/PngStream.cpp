@@ -0,0 +1,133 @@
+#include "Render/PngStream.h"
+
+#include <algorithm>
+#include <array>
+
+constexpr size_t DEFLATE_MAX_STORED = 65535;
+constexpr uint32_t ADLER_MODULO = 65521;
+// Longest run before the Adler-32 sums may overflow 32 bits
+constexpr size_t ADLER_BLOCK = 5552;
+
+namespace {
+
+uint32_t crc32(const std::string& data, uint32_t crc = 0xFFFFFFFF)
+{
+    static const std::array<uint32_t, 256> TABLE = []()
+    {
+        std::array<uint32_t, 256> table = {};
+        for (uint32_t n = 0; n < 256; ++n)
+        {
+            uint32_t c = n;
+            for (int k = 0; k < 8; ++k)
+            {
+                c = (c & 1) ? 0xEDB88320 ^ (c >> 1) : c >> 1;
+            }
+            table[n] = c;
+        }
+        return table;
+    }();
+
+    for (char byte : data)
+    {
+        crc = TABLE[(crc ^ static_cast<uint8_t>(byte)) & 0xFF] ^ (crc >> 8);
+    }
+    return crc;
+}
+
+void appendBigEndian(std::string* data, uint32_t value)
+{
+    for (int shift = 24; shift >= 0; shift -= 8)
+    {
+        data->push_back(static_cast<char>((value >> shift) & 0xFF));
+    }
+}
+
+} // namespace
+
+PngStream::PngStream(const std::string& filename, uint32_t width, uint32_t height) :
+    file_(filename, std::ios::binary), width_(width), height_(height)
+{
+    file_.write("\x89PNG\r\n\x1A\n", 8);
+
+    // 8 bits per channel, RGB, no interlacing
+    std::string header;
+    appendBigEndian(&header, width);
+    appendBigEndian(&header, height);
+    header += std::string("\x08\x02\x00\x00\x00", 5);
+    writeChunk("IHDR", header);
+}
+
+bool PngStream::good() const
+{
+    return file_.good();
+}
+
+void PngStream::writeRows(const uint8_t* rgb, uint32_t rows)
+{
+    rows = std::min(rows, height_ - rows_written_);
+    const size_t row_size = static_cast<size_t>(width_) * 3;
+
+    // Scanlines with the "none" filter
+    std::string scanlines;
+    scanlines.reserve((row_size + 1) * rows);
+    for (uint32_t row = 0; row < rows; ++row)
+    {
+        scanlines.push_back(0);
+        scanlines.append(reinterpret_cast<const char*>(rgb + row * row_size), row_size);
+    }
+
+    for (size_t i = 0; i < scanlines.size(); i += ADLER_BLOCK)
+    {
+        for (size_t j = i; j < std::min(i + ADLER_BLOCK, scanlines.size()); ++j)
+        {
+            adler_a_ += static_cast<uint8_t>(scanlines[j]);
+            adler_b_ += adler_a_;
+        }
+        adler_a_ %= ADLER_MODULO;
+        adler_b_ %= ADLER_MODULO;
+    }
+
+    rows_written_ += rows;
+    const bool last = rows_written_ == height_;
+
+    std::string data;
+    if (rows_written_ == rows)
+    {
+        data += "\x78\x01";
+    }
+    for (size_t offset = 0; offset < scanlines.size(); offset += DEFLATE_MAX_STORED)
+    {
+        size_t size = std::min(DEFLATE_MAX_STORED, scanlines.size() - offset);
+        bool final = last && (offset + size == scanlines.size());
+        data.push_back(final ? 1 : 0);
+        data.push_back(static_cast<char>(size & 0xFF));
+        data.push_back(static_cast<char>(size >> 8));
+        data.push_back(static_cast<char>(~size & 0xFF));
+        data.push_back(static_cast<char>((~size >> 8) & 0xFF));
+        data.append(scanlines, offset, size);
+    }
+    if (last)
+    {
+        appendBigEndian(&data, (adler_b_ << 16) | adler_a_);
+    }
+    writeChunk("IDAT", data);
+
+    if (last)
+    {
+        writeChunk("IEND", "");
+        file_.flush();
+    }
+}
+
+void PngStream::writeChunk(const char* type, const std::string& data)
+{
+    std::string chunk = std::string(type, 4) + data;
+    std::string tail;
+    appendBigEndian(&tail, crc32(chunk) ^ 0xFFFFFFFF);
+
+    std::string length;
+    appendBigEndian(&length, static_cast<uint32_t>(data.size()));
+    file_.write(length.data(), static_cast<std::streamsize>(length.size()));
+    file_.write(chunk.data(), static_cast<std::streamsize>(chunk.size()));
+    file_.write(tail.data(), static_cast<std::streamsize>(tail.size()));
+}
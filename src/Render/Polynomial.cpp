@@ -0,0 +1,140 @@
+#include "Render/Polynomial.h"
+
+Polynomial::Polynomial(size_t vars_num) : vars_num_(vars_num) {}
+
+Polynomial::Polynomial(size_t vars_num, const Coefficient& number) : vars_num_(vars_num)
+{
+    add(Monomial(vars_num_, 0), number);
+}
+
+Polynomial Polynomial::Variable(size_t vars_num, size_t var_ind)
+{
+    Polynomial poly(vars_num);
+    Monomial monomial(vars_num, 0);
+    monomial[var_ind] = 1;
+    poly.add(monomial, Coefficient(1.0));
+    return poly;
+}
+
+Polynomial Polynomial::operator + (const Polynomial& p) const
+{
+    Polynomial poly = *this;
+    for (const auto& [monomial, k] : p.terms_)
+    {
+        poly.add(monomial, k);
+    }
+    return poly;
+}
+
+Polynomial Polynomial::operator - (const Polynomial& p) const
+{
+    return *this + (-p);
+}
+
+Polynomial Polynomial::operator * (const Polynomial& p) const
+{
+    Polynomial poly(vars_num_);
+    for (const auto& [monomial1, k1] : terms_)
+    {
+        for (const auto& [monomial2, k2] : p.terms_)
+        {
+            Monomial monomial(vars_num_, 0);
+            for (size_t i = 0; i < vars_num_; ++i)
+            {
+                monomial[i] = monomial1[i] + monomial2[i];
+            }
+            poly.add(monomial, k1 * k2);
+        }
+    }
+    return poly;
+}
+
+Polynomial Polynomial::operator * (const Coefficient& k) const
+{
+    return *this * Polynomial(vars_num_, k);
+}
+
+Polynomial Polynomial::operator - () const
+{
+    return *this * Coefficient(-1.0);
+}
+
+Polynomial Polynomial::pow(unsigned power) const
+{
+    Polynomial poly(vars_num_, Coefficient(1.0));
+    Polynomial base = *this;
+    while (power != 0)
+    {
+        if (power & 1U)
+        {
+            poly = poly * base;
+        }
+        base = base * base;
+        power >>= 1U;
+    }
+    return poly;
+}
+
+bool Polynomial::isConstant() const
+{
+    for (const auto& [monomial, k] : terms_)
+    {
+        for (unsigned power : monomial)
+        {
+            if (power != 0)
+            {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+bool Polynomial::isApprox(const Polynomial& p, double tolerance) const
+{
+    Polynomial diff = *this - p;
+    for (const auto& [monomial, k] : diff.terms_)
+    {
+        if (std::abs(k) > tolerance)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+Polynomial::Coefficient Polynomial::coefficient(const Monomial& monomial) const
+{
+    auto it = terms_.find(monomial);
+    return (it == terms_.end()) ? Coefficient() : it->second;
+}
+
+unsigned Polynomial::degree(size_t var_ind) const
+{
+    unsigned degree = 0;
+    for (const auto& [monomial, k] : terms_)
+    {
+        degree = std::max(degree, monomial[var_ind]);
+    }
+    return degree;
+}
+
+size_t Polynomial::vars_num() const
+{
+    return vars_num_;
+}
+
+const std::map<Polynomial::Monomial, Polynomial::Coefficient>& Polynomial::terms() const
+{
+    return terms_;
+}
+
+void Polynomial::add(const Monomial& monomial, const Coefficient& k)
+{
+    Coefficient& term = terms_[monomial];
+    term += k;
+    if (term == Coefficient())
+    {
+        terms_.erase(monomial);
+    }
+}
@@ -0,0 +1,65 @@
+#include "Render/Poster.h"
+#include "Render/PngStream.h"
+
+#include <algorithm>
+
+Poster::Poster(const RenderJob& job) : job_(job) {}
+
+bool Poster::save(const Renderer& renderer, const std::string& filename, const std::function<void(double)>& progress, RenderStats* stats) const
+{
+    const uint32_t width = job_.size.x;
+    const uint32_t height = job_.size.y;
+    if ((width == 0) || (height == 0) || job_.formula.empty())
+    {
+        return false;
+    }
+
+    PngStream stream(filename, width, height);
+    if (!stream.good())
+    {
+        return false;
+    }
+
+    std::vector<uint8_t> band(static_cast<size_t>(width) * POSTER_BAND_ROWS * 3);
+    std::vector<uint8_t> pixels(static_cast<size_t>(POSTER_TILE_COLUMNS) * POSTER_BAND_ROWS * 4);
+    std::vector<SampleData> data(Renderer::SamplesNum(Renderer::SubJob(job_, vec2u(), vec2u(POSTER_TILE_COLUMNS, POSTER_BAND_ROWS))));
+
+    for (uint32_t row = 0; row < height; row += POSTER_BAND_ROWS)
+    {
+        const uint32_t rows = std::min(POSTER_BAND_ROWS, height - row);
+        for (uint32_t col = 0; col < width; col += POSTER_TILE_COLUMNS)
+        {
+            const uint32_t cols = std::min(POSTER_TILE_COLUMNS, width - col);
+
+            RenderJob tile_job = Renderer::SubJob(job_, vec2u(col, row), vec2u(cols, rows));
+
+            RenderStats tile_stats;
+            renderer.render(tile_job, data.data(), &tile_stats);
+            if (stats != nullptr)
+            {
+                stats->pixels += tile_stats.pixels;
+                stats->promoted += tile_stats.promoted;
+                stats->refined += tile_stats.refined;
+                stats->time += tile_stats.time;
+                stats->tail += tile_stats.tail;
+            }
+            Renderer::Colorize(tile_job, data.data(), pixels.data());
+
+            for (uint32_t r = 0; r < rows; ++r)
+            {
+                for (uint32_t c = 0; c < cols; ++c)
+                {
+                    std::copy_n(pixels.data() + (static_cast<size_t>(r) * cols + c) * 4, 3, band.data() + (static_cast<size_t>(r) * width + col + c) * 3);
+                }
+            }
+        }
+
+        stream.writeRows(band.data(), rows);
+        if (progress)
+        {
+            progress(static_cast<double>(row + rows) / static_cast<double>(height));
+        }
+    }
+
+    return stream.good();
+}
@@ -0,0 +1,55 @@
+#include "Render/PreviewQuality.h"
+
+#include <algorithm>
+#include <cmath>
+
+// Largest change of the render cost made after one frame, keeps a single slow frame from throwing the quality off
+constexpr double MAX_COST_STEP = 2.0;
+
+PreviewQuality::PreviewQuality(double frame_time) : frame_time_(frame_time) {}
+
+RenderJob PreviewQuality::previewJob(const RenderJob& job) const
+{
+    RenderJob preview = job;
+    const double scale = this->scale();
+    preview.size = vec2u(std::max(static_cast<uint32_t>(std::lround(static_cast<double>(job.size.x) / scale)), 1U),
+                         std::max(static_cast<uint32_t>(std::lround(static_cast<double>(job.size.y) / scale)), 1U));
+    preview.itrn_max = std::max(static_cast<size_t>(std::lround(static_cast<double>(job.itrn_max) * iterationRatio())),
+                                std::min(job.itrn_max, MIN_PREVIEW_ITERATION));
+    preview.antialiasing = 0;
+    preview.adaptive_antialiasing = false;
+    return preview;
+}
+
+void PreviewQuality::update(double render_time)
+{
+    // Cost is the share of full quality work, 1 / scale^2 of the pixels times the share of iterations
+    const double min_cost = MIN_PREVIEW_ITERATION_RATIO / (MAX_PREVIEW_SCALE * MAX_PREVIEW_SCALE);
+    const double step = std::clamp(frame_time_ / std::max(render_time, 1e-6), 1.0 / MAX_COST_STEP, MAX_COST_STEP);
+    cost_ = std::clamp(cost_ * step, min_cost, 1.0);
+}
+
+double PreviewQuality::scale() const
+{
+    // Resolution goes first, iterations are cut only below the lowest resolution
+    return std::clamp(1.0 / std::sqrt(cost_), 1.0, MAX_PREVIEW_SCALE);
+}
+
+double PreviewQuality::iterationRatio() const
+{
+    const double scale = this->scale();
+    return std::clamp(cost_ * scale * scale, MIN_PREVIEW_ITERATION_RATIO, 1.0);
+}
+
+void PreviewQuality::Upscale(const uint8_t* pixels, const vec2u& size, uint8_t* upscaled, const vec2u& upscaled_size)
+{
+    for (uint32_t y = 0; y < upscaled_size.y; ++y)
+    {
+        const uint32_t src_y = static_cast<uint32_t>(static_cast<uint64_t>(y) * size.y / upscaled_size.y);
+        for (uint32_t x = 0; x < upscaled_size.x; ++x)
+        {
+            const uint32_t src_x = static_cast<uint32_t>(static_cast<uint64_t>(x) * size.x / upscaled_size.x);
+            std::copy_n(pixels + (static_cast<size_t>(src_y) * size.x + src_x) * 4, 4, upscaled + (static_cast<size_t>(y) * upscaled_size.x + x) * 4);
+        }
+    }
+}
@@ -0,0 +1,150 @@
+#include "Render/RenderPipeline.h"
+
+RenderPipeline::RenderPipeline(size_t threads_num) : renderer_(threads_num)
+{
+    renderer_.setCancelFlag(&cancel_);
+    thread_ = std::thread(&RenderPipeline::run, this);
+}
+
+RenderPipeline::~RenderPipeline()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+        cancel_ = true;
+    }
+    condition_.notify_one();
+    thread_.join();
+}
+
+uint64_t RenderPipeline::submit(const RenderJob& job)
+{
+    uint64_t generation = 0;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        generation = ++generation_;
+        pending_job_ = job;
+        pending_ = true;
+        cancel_ = true;
+    }
+    condition_.notify_one();
+    return generation;
+}
+
+void RenderPipeline::cancel()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    ++generation_;
+    pending_ = false;
+    has_result_ = false;
+    cancel_ = true;
+}
+
+bool RenderPipeline::poll(RenderResult* result)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!has_result_)
+    {
+        return false;
+    }
+
+    *result = std::move(result_);
+    has_result_ = false;
+    return true;
+}
+
+bool RenderPipeline::busy() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return pending_ || rendering_;
+}
+
+void RenderPipeline::run()
+{
+    while (true)
+    {
+        RenderJob job;
+        uint64_t generation = 0;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            condition_.wait(lock, [this]() { return pending_ || stop_; });
+            if (stop_)
+            {
+                return;
+            }
+
+            // Only the newest job is kept, the ones submitted in between were never started
+            job = std::move(pending_job_);
+            generation = generation_;
+            pending_ = false;
+            rendering_ = true;
+            cancel_ = false;
+        }
+
+        renderJob(job, generation);
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        rendering_ = false;
+    }
+}
+
+void RenderPipeline::renderJob(const RenderJob& job, uint64_t generation)
+{
+    const size_t frame_size = static_cast<size_t>(job.size.x) * job.size.y;
+    const size_t samples_num = Renderer::SamplesNum(job);
+
+    RenderResult result;
+    result.generation = generation;
+    result.job = job;
+    result.pixels.resize(frame_size * 4);
+    result.caching = SamplePyramid::Supports(job);
+
+    if (result.caching)
+    {
+        // Each pass within the time budget is shown, the next one refines it
+        samples_.clear();
+        while (!result.complete)
+        {
+            result.complete = pyramid_.render(renderer_, job, result.pixels.data(), &result.stats);
+            if (cancel_)
+            {
+                return;
+            }
+            result.cache_stats = pyramid_.cacheStats();
+            publish(result);
+        }
+        return;
+    }
+
+    // Cached samples serve panning, samples of a cancelled render are incomplete and dropped
+    if (samples_.size() == samples_num)
+    {
+        renderer_.renderIncremental(rendered_job_, job, samples_.data(), &result.stats);
+    }
+    else
+    {
+        samples_.resize(samples_num);
+        renderer_.render(job, samples_.data(), &result.stats);
+    }
+
+    if (cancel_)
+    {
+        samples_.clear();
+        return;
+    }
+    rendered_job_ = job;
+
+    Renderer::Colorize(job, samples_.data(), result.pixels.data());
+    result.complete = true;
+    publish(result);
+}
+
+void RenderPipeline::publish(const RenderResult& result)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (result.generation == generation_)
+    {
+        result_ = result;
+        has_result_ = true;
+    }
+}
@@ -0,0 +1,205 @@
+#include "Render/RenderTask.h"
+
+#include <algorithm>
+#include <iomanip>
+#include <limits>
+#include <sstream>
+
+namespace
+{
+const std::vector<std::string> INPUT_MODE_NAMES = {"z", "xy"};
+const std::vector<std::string> FRACTAL_MODE_NAMES = {"main", "julia"};
+const std::vector<std::string> RENDERING_MODE_NAMES = {"default", "tracer", "complex_domain", "kali", "density", "distance", "newton", "inverse"};
+const std::vector<std::string> PRECISION_NAMES = {"single", "double", "double_double"};
+const std::vector<std::string> PALETTE_NAMES = {"rainbow", "fire", "ocean", "grayscale"};
+const std::vector<std::string> LAYOUT_NAMES = {"linear", "tiled"};
+
+// Enumerations are written by name, numbers are accepted too
+bool readEnum(std::stringstream& values, const std::vector<std::string>& names, size_t* value)
+{
+    std::string word;
+    if (!(values >> word))
+    {
+        return false;
+    }
+
+    auto name = std::find(names.begin(), names.end(), word);
+    if (name != names.end())
+    {
+        *value = static_cast<size_t>(name - names.begin());
+        return true;
+    }
+
+    std::stringstream number(word);
+    size_t index = 0;
+    if ((number >> index) && number.eof() && (index < names.size()))
+    {
+        *value = index;
+        return true;
+    }
+    return false;
+}
+
+const std::string& writeEnum(const std::vector<std::string>& names, size_t value)
+{
+    static const std::string unknown = "unknown";
+    return (value < names.size()) ? names[value] : unknown;
+}
+}
+
+bool RenderTask::compile()
+{
+    ASTz::Error err_z = ASTz::Error::OK;
+    ASTx::Error err_x = ASTx::Error::OK;
+    ASTx::Error err_y = ASTx::Error::OK;
+
+    switch (input_mode)
+    {
+    case Z_INPUT:
+    {
+        ASTz z(expression_z, &err_z);
+        job.formula = (err_z == ASTz::Error::OK) ? Formula(z) : Formula();
+        break;
+    }
+    case XY_INPUT:
+    {
+        ASTx x(expression_x, &err_x);
+        ASTx y(expression_y, &err_y);
+        job.formula = ((err_x == ASTx::Error::OK) && (err_y == ASTx::Error::OK)) ? Formula(x, y) : Formula();
+        break;
+    }
+    default:
+    {
+        job.formula = Formula();
+        break;
+    }
+    }
+    return !job.formula.empty();
+}
+
+size_t RenderTask::tilesX() const
+{
+    return (job.size.x + tile_size.x - 1) / tile_size.x;
+}
+
+size_t RenderTask::tilesY() const
+{
+    return (job.size.y + tile_size.y - 1) / tile_size.y;
+}
+
+vec2u RenderTask::tilePosition(size_t tile) const
+{
+    return vec2u(static_cast<uint32_t>(tile % tilesX()) * tile_size.x, static_cast<uint32_t>(tile / tilesX()) * tile_size.y);
+}
+
+RenderJob RenderTask::tileJob(size_t tile) const
+{
+    vec2u position = tilePosition(tile);
+    vec2u size(std::min(tile_size.x, job.size.x - position.x), std::min(tile_size.y, job.size.y - position.y));
+    return Renderer::SubJob(job, position, size);
+}
+
+std::string RenderTask::serialize() const
+{
+    std::stringstream text;
+    text << std::setprecision(std::numeric_limits<double>::max_digits10);
+    text << "input_mode " << writeEnum(INPUT_MODE_NAMES, input_mode) << "\n";
+    text << "expression_z " << expression_z << "\n";
+    text << "expression_x " << expression_x << "\n";
+    text << "expression_y " << expression_y << "\n";
+    text << "fractal_mode " << writeEnum(FRACTAL_MODE_NAMES, job.fractal_mode) << "\n";
+    text << "rendering_mode " << writeEnum(RENDERING_MODE_NAMES, job.rendering_mode) << "\n";
+    text << "antialiasing " << job.antialiasing << "\n";
+    text << "adaptive_antialiasing " << job.adaptive_antialiasing << "\n";
+    text << "itrn_max " << job.itrn_max << "\n";
+    text << "limit " << job.limit << "\n";
+    text << "frequency " << job.frequency << "\n";
+    text << "julia_point " << job.julia_point.x << " " << job.julia_point.y << "\n";
+    text << "borders " << job.borders.left.hi << " " << job.borders.left.lo << " " << job.borders.right.hi << " " << job.borders.right.lo << " " <<
+        job.borders.bottom.hi << " " << job.borders.bottom.lo << " " << job.borders.top.hi << " " << job.borders.top.lo << "\n";
+    text << "size " << job.size.x << " " << job.size.y << "\n";
+    text << "precision " << writeEnum(PRECISION_NAMES, job.precision) << "\n";
+    text << "deep_zoom " << job.deep_zoom << "\n";
+    text << "palette " << writeEnum(PALETTE_NAMES, job.palette) << "\n";
+    text << "trace_frequency " << job.trace_frequency << "\n";
+    text << "layout " << writeEnum(LAYOUT_NAMES, job.layout) << "\n";
+    text << "tile_size " << tile_size.x << " " << tile_size.y << "\n";
+    return text.str();
+}
+
+bool RenderTask::Parse(const std::string& text, RenderTask* task)
+{
+    std::stringstream lines(text);
+    std::string line;
+    while (std::getline(lines, line))
+    {
+        std::stringstream fields(line);
+        std::string key;
+        if (!(fields >> key) || (key[0] == '#'))
+        {
+            continue;
+        }
+
+        std::string rest;
+        std::getline(fields >> std::ws, rest);
+        std::stringstream values(rest);
+
+        RenderJob& job = task->job;
+        bool ok = true;
+        if (key == "input_mode")                 { ok = readEnum(values, INPUT_MODE_NAMES, &task->input_mode); }
+        else if (key == "expression_z")          { task->expression_z = rest; }
+        else if (key == "expression_x")          { task->expression_x = rest; }
+        else if (key == "expression_y")          { task->expression_y = rest; }
+        else if (key == "fractal_mode")          { ok = readEnum(values, FRACTAL_MODE_NAMES, &job.fractal_mode); }
+        else if (key == "rendering_mode")        { ok = readEnum(values, RENDERING_MODE_NAMES, &job.rendering_mode); }
+        else if (key == "antialiasing")          { ok = static_cast<bool>(values >> job.antialiasing); }
+        else if (key == "adaptive_antialiasing") { ok = static_cast<bool>(values >> job.adaptive_antialiasing); }
+        else if (key == "itrn_max")              { ok = static_cast<bool>(values >> job.itrn_max); }
+        else if (key == "limit")                 { ok = static_cast<bool>(values >> job.limit); }
+        else if (key == "frequency")             { ok = static_cast<bool>(values >> job.frequency); }
+        else if (key == "julia_point")           { ok = static_cast<bool>(values >> job.julia_point.x >> job.julia_point.y); }
+        else if (key == "size")                  { ok = static_cast<bool>(values >> job.size.x >> job.size.y); }
+        else if (key == "precision")             { ok = readEnum(values, PRECISION_NAMES, &job.precision); }
+        else if (key == "deep_zoom")             { ok = static_cast<bool>(values >> job.deep_zoom); }
+        else if (key == "palette")               { ok = readEnum(values, PALETTE_NAMES, &job.palette); }
+        else if (key == "trace_frequency")       { ok = static_cast<bool>(values >> job.trace_frequency); }
+        else if (key == "layout")                { ok = readEnum(values, LAYOUT_NAMES, &job.layout); }
+        else if (key == "tile_size")             { ok = static_cast<bool>(values >> task->tile_size.x >> task->tile_size.y); }
+        else if (key == "borders")
+        {
+            // Either left right bottom top, or each of them as a high and a low part
+            std::vector<double> numbers;
+            double number = 0.0;
+            while (values >> number)
+            {
+                numbers.push_back(number);
+            }
+
+            if (numbers.size() == 4)
+            {
+                job.borders = Borders2D<DoubleDouble>(numbers[0], numbers[1], numbers[2], numbers[3]);
+            }
+            else if (numbers.size() == 8)
+            {
+                job.borders = Borders2D<DoubleDouble>(DoubleDouble(numbers[0]) + numbers[1], DoubleDouble(numbers[2]) + numbers[3],
+                                                      DoubleDouble(numbers[4]) + numbers[5], DoubleDouble(numbers[6]) + numbers[7]);
+            }
+            else
+            {
+                ok = false;
+            }
+            task->has_borders = ok;
+        }
+        else
+        {
+            ok = false;
+        }
+
+        if (!ok)
+        {
+            return false;
+        }
+    }
+
+    return (task->tile_size.x > 0) && (task->tile_size.y > 0) && task->compile();
+}
@@ -0,0 +1,973 @@
+#include "Render/Renderer.h"
+#include "Render/FrameSymmetry.h"
+#include "Render/InverseIteration.h"
+#include "Render/OrbitDensity.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <memory>
+#include <string_view>
+
+namespace {
+
+constexpr float PI = 3.14159265358979F;
+constexpr float PROMOTION_ULPS = 16.0F;
+constexpr float PROMOTION_TOLERANCE = 0.5F;
+constexpr float DERIVATIVE_RESCALE = 1e-10F;
+constexpr double PAN_TOLERANCE = 0.01;
+constexpr float EDGE_THRESHOLD = 0.05F;
+
+template <typename T>
+inline T dot(const std::complex<T>& a, const std::complex<T>& b)
+{
+    return a.real() * b.real() + a.imag() * b.imag();
+}
+
+inline Color hsvColor(float hue, float saturation, float value)
+{
+    auto channel = [&](float k)
+    {
+        float fract = hue + k - std::floor(hue + k);
+        float p = std::abs(fract * 6.0F - 3.0F);
+        return value * (1.0F + (std::clamp(p - 1.0F, 0.0F, 1.0F) - 1.0F) * saturation);
+    };
+    return { channel(1.0F), channel(2.0F / 3.0F), channel(1.0F / 3.0F) };
+}
+
+inline Color domainColor(const std::complex<float>& z)
+{
+    float magnitude = std::abs(z);
+    float phase = std::arg(z);
+    float color_lightness = (0.5F + std::atan(0.5F * std::log(magnitude)) / PI) * 2.0F;
+    float color_saturation = 1.0F - std::abs(color_lightness - 1.0F);
+    float color_value = (color_lightness + color_saturation) / 2.0F;
+    color_saturation /= color_value;
+
+    return hsvColor(phase / (2.0F * PI), color_saturation, color_value);
+}
+
+// Hue of the root, turned by its distance from the origin so that roots on one ray differ too, darkened by the steps it took
+inline Color basinColor(const std::complex<float>& root, size_t itrn, float last_step)
+{
+    float hue = (std::arg(root) + std::atan(std::log(std::abs(root)))) / (2.0F * PI);
+
+    // Quadratic convergence squares the step, the fraction of a step left to the tolerance blends neighbouring counts
+    float fraction = std::clamp(std::log2(std::log(last_step) / std::log(NEWTON_TOLERANCE)), 0.0F, 1.0F);
+    return hsvColor(hue, 1.0F, std::pow(NEWTON_FADE, static_cast<float>(itrn) - fraction));
+}
+
+template <typename T>
+inline T modulus(const std::complex<T>& z)
+{
+    return std::sqrt(std::norm(z));
+}
+
+template <typename T, typename Step>
+SampleData sampleData(const RenderJob& job, const Step& step, const std::complex<T>& point, T frequency, T tolerance = T(0.0), bool* promote = nullptr)
+{
+    std::complex<T> z = point;
+    std::complex<T> c = (job.fractal_mode == MAIN) ? point : std::complex<T>(job.julia_point.x, job.julia_point.y);
+    std::complex<T> pz = z;
+    std::complex<T> ppz;
+
+    T sum[3] = {};
+    T weight = T(1.0);
+
+    // Rounding error of the orbit against the distance to orbits of neighbouring samples
+    const bool tracking = (promote != nullptr) && job.formula.isQuadratic() &&
+        ((job.rendering_mode == DEFAULT) || (job.rendering_mode == TRACER));
+    const T epsilon = std::numeric_limits<T>::epsilon();
+    const T dc = (job.fractal_mode == MAIN) ? T(1.0) : T(0.0);
+    std::complex<T> der = T(1.0);
+    T error = epsilon * modulus(z);
+
+    // Derivatives of z by the real and imaginary parts of the point, for the distance to the boundary
+    const bool distance = job.rendering_mode == DISTANCE;
+    std::complex<T> dz[2] = { T(1.0), std::complex<T>(T(0.0), T(1.0)) };
+
+    size_t itrn = 0;
+    if (job.formula.isQuadratic() && (job.fractal_mode == MAIN) && ((job.rendering_mode == DEFAULT) || distance) && (job.limit >= 2.0F) &&
+        InsideQuadraticInterior(point.real(), point.imag()))
+    {
+        itrn = job.itrn_max;
+    }
+
+    for (; itrn < job.itrn_max; ++itrn)
+    {
+        if (tracking)
+        {
+            der = T(2.0) * z * der + dc;
+            error *= T(2.0) * modulus(z);
+        }
+        if (distance)
+        {
+            job.formula.derivative(z, c, job.fractal_mode == MAIN, dz);
+        }
+
+        ppz = pz;
+        pz = z;
+        z = step(z, c);
+
+        if (tracking)
+        {
+            error += epsilon * modulus(z);
+            if (error * error > tolerance * tolerance * std::norm(der))
+            {
+                *promote = true;
+                return {};
+            }
+            if (std::norm(der) > T(1.0) / (DERIVATIVE_RESCALE * DERIVATIVE_RESCALE))
+            {
+                der *= T(DERIVATIVE_RESCALE);
+                error *= T(DERIVATIVE_RESCALE);
+            }
+        }
+
+        if ((job.rendering_mode == DEFAULT) || (job.rendering_mode == TRACER) || distance)
+        {
+            if (std::abs(z) > job.limit)
+            {
+                break;
+            }
+
+            if (job.rendering_mode == TRACER)
+            {
+                sum[0] += dot(z - pz, pz - ppz);
+                sum[1] += dot(z - pz, z - pz);
+                sum[2] += dot(z - ppz, z - ppz);
+            }
+        }
+        else if (job.rendering_mode == NEWTON)
+        {
+            // Stops on the root, steps that overflow never converge
+            const T step = std::norm(z - pz);
+            if (!std::isfinite(step))
+            {
+                itrn = job.itrn_max;
+                break;
+            }
+            if (step <= T(NEWTON_TOLERANCE * NEWTON_TOLERANCE) * std::max(std::norm(z), T(1.0)))
+            {
+                sum[0] = std::sqrt(step / std::max(std::norm(z), T(1.0)));
+                break;
+            }
+        }
+        else if (job.rendering_mode == KALI)
+        {
+            T r = dot(z, z);
+            if (r > T(1.0))
+            {
+                z /= r;
+            }
+            weight *= frequency;
+            sum[0] += z.real() * z.real() * weight;
+            sum[1] += z.imag() * z.imag() * weight;
+            sum[2] += std::abs(z.real() * z.imag()) * weight;
+        }
+    }
+
+    if (distance && (itrn < job.itrn_max))
+    {
+        // |z| log|z| / |dz| once escaped, derivatives overflow only right next to the boundary
+        const T radius = modulus(z);
+        const T estimate = radius * std::log(radius) / std::sqrt(T(0.5) * (std::norm(dz[0]) + std::norm(dz[1])));
+        sum[0] = std::isfinite(estimate) ? estimate : T(0.0);
+    }
+
+    return { static_cast<uint32_t>(itrn), std::complex<float>(z), { static_cast<float>(sum[0]), static_cast<float>(sum[1]), static_cast<float>(sum[2]) } };
+}
+
+// Escape time sample carried on from the iteration it stopped at, samples that escaped or stopped past the limit stay
+template <typename T, typename Step>
+SampleData resumeData(const RenderJob& job, const Step& step, const std::complex<T>& point, const SampleData& sample)
+{
+    std::complex<T> z(sample.z);
+    if ((sample.itrn >= job.itrn_max) || (std::abs(z) > job.limit))
+    {
+        return sample;
+    }
+
+    // Samples skipped inside the main cardioid and bulb never started iterating
+    const std::complex<T> c = (job.fractal_mode == MAIN) ? point : std::complex<T>(job.julia_point.x, job.julia_point.y);
+    size_t itrn = sample.itrn;
+    if (job.formula.isQuadratic() && (job.fractal_mode == MAIN) && (job.limit >= 2.0F) && InsideQuadraticInterior(point.real(), point.imag()))
+    {
+        itrn = job.itrn_max;
+    }
+
+    for (; itrn < job.itrn_max; ++itrn)
+    {
+        z = step(z, c);
+        if (std::abs(z) > job.limit)
+        {
+            break;
+        }
+    }
+    return { static_cast<uint32_t>(itrn), std::complex<float>(z), {} };
+}
+
+template <typename Step>
+size_t renderRow(const RenderJob& job, const Step& step, const Perturbation* perturbation, uint32_t row, uint32_t col_begin, uint32_t col_end,
+                 uint32_t col_step, size_t sample_begin, size_t sample_end, SampleData* data, bool resume)
+{
+    const size_t aa = job.antialiasing + 1;
+    const double frequency = 1.0 / (1.0 + std::exp(-static_cast<double>(job.frequency)));
+    const double left = static_cast<double>(job.borders.left);
+    const double top = static_cast<double>(job.borders.top);
+    const double width = static_cast<double>(job.borders.width());
+    const double height = static_cast<double>(job.borders.height());
+    const double size_x = static_cast<double>(job.size.x);
+    const double size_y = static_cast<double>(job.size.y);
+
+    // Float is tried first unless the sample spacing is close to its ulp on this row
+    const double spacing = std::min(width / size_x, height / size_y) / static_cast<double>(aa);
+    const double y = top - height * (static_cast<double>(row) + 0.5) / size_y;
+    const double magnitude = std::max({ std::abs(left), std::abs(left + width), std::abs(y) });
+    const bool mixed = (job.precision != SINGLE_PRECISION) && (perturbation == nullptr);
+    const bool row_promoted = mixed && (spacing < PROMOTION_ULPS * std::numeric_limits<float>::epsilon() * magnitude);
+    const float tolerance = static_cast<float>(PROMOTION_TOLERANCE * spacing);
+
+    const SampleLayout layout(job.size, job.layout);
+    size_t promoted = 0;
+    for (uint32_t col = col_begin; col < col_end; col += col_step)
+    {
+        SampleData* samples = data + layout(col, row) * aa * aa;
+        bool pixel_promoted = row_promoted;
+        for (size_t k = sample_begin; k < sample_end; ++k)
+        {
+            const size_t sx = k / aa;
+            const size_t sy = k % aa;
+            double px = static_cast<double>(col) + 0.5 + static_cast<double>(sx) / static_cast<double>(aa);
+            double py = static_cast<double>(row) + 0.5 + static_cast<double>(sy) / static_cast<double>(aa);
+
+            if (perturbation != nullptr)
+            {
+                std::complex<double> dc(width * (px - 0.5 * size_x) / size_x, height * (0.5 * size_y - py) / size_y);
+                samples[k] = { static_cast<uint32_t>(perturbation->iterate(dc)), {}, {} };
+                continue;
+            }
+
+            std::complex<double> point(left + width * px / size_x, top - height * py / size_y);
+            if (job.precision == SINGLE_PRECISION)
+            {
+                samples[k] = resume ? resumeData(job, step, std::complex<float>(point), samples[k]) :
+                                      sampleData(job, step, std::complex<float>(point), static_cast<float>(frequency));
+                continue;
+            }
+
+            bool promote = row_promoted;
+            SampleData sample;
+            if (!promote)
+            {
+                sample = sampleData(job, step, std::complex<float>(point), static_cast<float>(frequency), tolerance, &promote);
+            }
+            if (promote)
+            {
+                sample = sampleData(job, step, point, frequency);
+                pixel_promoted = true;
+            }
+            samples[k] = sample;
+        }
+        promoted += pixel_promoted;
+    }
+    return promoted;
+}
+
+template <typename T>
+SampleData pointSample(const RenderJob& job, const std::complex<double>& point, double frequency)
+{
+    auto formula_step = [&job](const std::complex<T>& z, const std::complex<T>& c) { return job.formula(z, c); };
+    auto quadratic_step = [](const std::complex<T>& z, const std::complex<T>& c)
+    {
+        return std::complex<T>(z.real() * z.real() - z.imag() * z.imag() + c.real(), T(2.0) * z.real() * z.imag() + c.imag());
+    };
+
+    auto newton_step = [&job](const std::complex<T>& z, const std::complex<T>& c) { return job.formula.newton(z, c); };
+
+    if (job.rendering_mode == NEWTON)
+    {
+        return sampleData(job, newton_step, std::complex<T>(point), static_cast<T>(frequency));
+    }
+    if (job.formula.isQuadratic())
+    {
+        return sampleData(job, quadratic_step, std::complex<T>(point), static_cast<T>(frequency));
+    }
+    return sampleData(job, formula_step, std::complex<T>(point), static_cast<T>(frequency));
+}
+
+bool isEdge(const RenderJob& job, const Palette& palette, const SampleData* data, uint32_t col, uint32_t row)
+{
+    const size_t samples_num = (job.antialiasing + 1) * (job.antialiasing + 1);
+    const SampleLayout layout(job.size, job.layout);
+    auto first = [&](uint32_t x, uint32_t y) -> const SampleData& { return data[layout(x, y) * samples_num]; };
+
+    const SampleData& sample = first(col, row);
+    const Color color = Renderer::Shade(job, palette, sample);
+    const bool inside = sample.itrn >= job.itrn_max;
+
+    const int neighbours[4][2] = { { -1, 0 }, { 1, 0 }, { 0, -1 }, { 0, 1 } };
+    for (const auto& neighbour : neighbours)
+    {
+        int64_t x = static_cast<int64_t>(col) + neighbour[0];
+        int64_t y = static_cast<int64_t>(row) + neighbour[1];
+        if ((x < 0) || (y < 0) || (x >= job.size.x) || (y >= job.size.y))
+        {
+            continue;
+        }
+
+        const SampleData& other = first(static_cast<uint32_t>(x), static_cast<uint32_t>(y));
+        const Color other_color = Renderer::Shade(job, palette, other);
+        if ((inside != (other.itrn >= job.itrn_max)) ||
+            (std::max({ std::abs(color.r - other_color.r), std::abs(color.g - other_color.g), std::abs(color.b - other_color.b) }) > EDGE_THRESHOLD))
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+} // namespace
+
+Renderer::Renderer(size_t threads_num) : threads_num_(std::max<size_t>(threads_num, 1)) {}
+
+void Renderer::render(const RenderJob& job, uint8_t* pixels, RenderStats* stats) const
+{
+    std::vector<SampleData> data(SamplesNum(job));
+    render(job, data.data(), stats);
+    Colorize(job, data.data(), pixels);
+}
+
+void Renderer::render(const RenderJob& job, SampleData* data, RenderStats* stats) const
+{
+    renderFrame(job, data, stats, false);
+}
+
+void Renderer::render(const RenderJob& job, const std::vector<RenderRegion>& regions, SampleData* data, RenderStats* stats) const
+{
+    renderRegions(job, regions, data, stats, false);
+}
+
+void Renderer::resume(const RenderJob& job, SampleData* data, RenderStats* stats) const
+{
+    renderFrame(job, data, stats, true);
+}
+
+void Renderer::renderFrame(const RenderJob& job, SampleData* data, RenderStats* stats, bool resume) const
+{
+    // Mirrored part of the view is copied from the samples it mirrors once they are done
+    const FrameSymmetry symmetry(job);
+    if (symmetry.empty())
+    {
+        renderRegions(job, { { vec2u(), job.size } }, data, stats, resume);
+        return;
+    }
+
+    renderRegions(job, symmetry.regions(), data, stats, resume);
+    if (!cancelled())
+    {
+        symmetry.fill(data);
+    }
+}
+
+template <typename Function>
+void Renderer::forEachRow(const RenderJob& job, const std::vector<RenderRegion>& regions, const Function& function, RenderStats* stats,
+                          bool modeled) const
+{
+    // Spans of a tiled frame cover a band of tiles and are walked one tile column at a time, so a tile stays in cache
+    // while all its rows are done
+    const uint32_t band = (job.layout == TILED_LAYOUT) ? LAYOUT_TILE_SIZE : 1;
+    std::vector<RowSpan> spans;
+    for (size_t region_ind = 0; region_ind < regions.size(); ++region_ind)
+    {
+        const RenderRegion& region = regions[region_ind];
+        for (uint32_t i = 0; i < region.size.y;)
+        {
+            const uint32_t row = region.position.y + i * region.step.y;
+            uint32_t rows = 1;
+            while ((i + rows < region.size.y) && ((row + rows * region.step.y) / band == row / band))
+            {
+                ++rows;
+            }
+            spans.push_back({ region_ind, row, rows, region.step.y, region.position.x, region.position.x + region.size.x * region.step.x,
+                              region.step.x, 0.0 });
+            i += rows;
+        }
+    }
+    if (modeled)
+    {
+        spans = scheduleSpans(job, std::move(spans));
+    }
+
+    auto run_span = [&](const RowSpan& span)
+    {
+        if (span.rows == 1)
+        {
+            function(regions[span.region], span);
+            return;
+        }
+
+        RowSpan row_span = span;
+        row_span.rows = 1;
+        for (uint32_t begin = span.col_begin; begin < span.col_end; begin = row_span.col_end)
+        {
+            // Chunks end on a tile boundary and the next one starts on the column grid of the span
+            const uint32_t end = std::min((begin / LAYOUT_TILE_SIZE + 1) * LAYOUT_TILE_SIZE, span.col_end);
+            row_span.col_begin = begin;
+            row_span.col_end = std::min(span.col_begin + (end - span.col_begin + span.col_step - 1) / span.col_step * span.col_step, span.col_end);
+            for (uint32_t i = 0; i < span.rows; ++i)
+            {
+                row_span.row = span.row + i * span.row_step;
+                function(regions[span.region], row_span);
+            }
+        }
+    };
+
+    // Every span is timed, the spread of the threads' finishing times is the tail left by the schedule
+    using Clock = std::chrono::steady_clock;
+    const Clock::time_point start = Clock::now();
+    std::vector<Clock::time_point> finish(threads_num_);
+    std::atomic<size_t> next_span = 0;
+    auto worker = [&](size_t thread_ind)
+    {
+        for (size_t ind = next_span++; (ind < spans.size()) && !cancelled(); ind = next_span++)
+        {
+            const Clock::time_point span_start = Clock::now();
+            run_span(spans[ind]);
+            spans[ind].cost = std::chrono::duration<double>(Clock::now() - span_start).count();
+        }
+        finish[thread_ind] = Clock::now();
+    };
+
+    std::vector<std::thread> threads;
+    for (size_t i = 1; i < threads_num_; ++i)
+    {
+        threads.emplace_back(worker, i);
+    }
+    worker(0);
+
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+
+    if (stats != nullptr)
+    {
+        auto [first, last] = std::minmax_element(finish.begin(), finish.end());
+        stats->time += std::chrono::duration<double>(*last - start).count();
+        stats->tail += std::chrono::duration<double>(*last - *first).count();
+    }
+    if (modeled && !cancelled())
+    {
+        std::lock_guard<std::mutex> lock(cost_mutex_);
+        cost_model_.record(job, spans);
+    }
+}
+
+std::vector<RowSpan> Renderer::scheduleSpans(const RenderJob& job, std::vector<RowSpan> spans) const
+{
+    std::lock_guard<std::mutex> lock(cost_mutex_);
+    if (!cost_prediction_ || (threads_num_ == 1) || !cost_model_.similar(job))
+    {
+        return spans;
+    }
+
+    cost_model_.predict(job, &spans);
+    double total = 0.0;
+    for (const RowSpan& span : spans)
+    {
+        total += span.cost;
+    }
+
+    // Spans above a fair share are split into pieces of whole cells, then the most expensive pieces are handed out first
+    const double share = total / static_cast<double>(threads_num_ * SPANS_PER_THREAD);
+    std::vector<RowSpan> scheduled;
+    for (const RowSpan& span : spans)
+    {
+        const uint32_t pixels = (span.col_end - span.col_begin + span.col_step - 1) / span.col_step;
+        const uint32_t pieces = std::clamp(static_cast<uint32_t>(std::ceil(span.cost / std::max(share, 1e-12))), 1U,
+                                           std::max(pixels / COST_CELL_WIDTH, 1U));
+        const uint32_t piece_pixels = (pixels + pieces - 1) / pieces;
+        for (uint32_t begin = 0; begin < pixels; begin += piece_pixels)
+        {
+            RowSpan piece = span;
+            piece.col_begin = span.col_begin + begin * span.col_step;
+            piece.col_end = std::min(piece.col_begin + piece_pixels * span.col_step, span.col_end);
+            piece.cost = span.cost * static_cast<double>(std::min(piece_pixels, pixels - begin)) / static_cast<double>(pixels);
+            scheduled.push_back(piece);
+        }
+    }
+
+    std::stable_sort(scheduled.begin(), scheduled.end(), [](const RowSpan& a, const RowSpan& b) { return a.cost > b.cost; });
+    return scheduled;
+}
+
+void Renderer::renderRegions(const RenderJob& job, const std::vector<RenderRegion>& regions, SampleData* data, RenderStats* stats,
+                             bool resume) const
+{
+    if (job.formula.empty())
+    {
+        return;
+    }
+
+    // Orbits land anywhere in the frame, so it is rendered whole
+    if (job.rendering_mode == ORBIT_DENSITY)
+    {
+        OrbitDensity(job).render(*this, data, stats);
+        return;
+    }
+
+    // Preimages land anywhere in the frame too, formulas without inverse branches fall back to escape time
+    if (job.rendering_mode == INVERSE_ITERATION)
+    {
+        if (InverseIteration::Supports(job))
+        {
+            InverseIteration(job).render(*this, data, stats);
+            return;
+        }
+        RenderJob escape_job = job;
+        escape_job.rendering_mode = DEFAULT;
+        render(escape_job, regions, data, stats);
+        return;
+    }
+
+    std::unique_ptr<Perturbation> perturbation;
+    if (IsDeepZoom(job))
+    {
+        double width = static_cast<double>(job.borders.width());
+        double height = static_cast<double>(job.borders.height());
+        perturbation = std::make_unique<Perturbation>(job.borders.center(), job.itrn_max, job.limit, 0.5 * std::hypot(width, height));
+    }
+
+    auto formula_step = [&job]<typename T>(const std::complex<T>& z, const std::complex<T>& c) { return job.formula(z, c); };
+    auto quadratic_step = []<typename T>(const std::complex<T>& z, const std::complex<T>& c)
+    {
+        return std::complex<T>(z.real() * z.real() - z.imag() * z.imag() + c.real(), T(2.0) * z.real() * z.imag() + c.imag());
+    };
+    auto newton_step = [&job]<typename T>(const std::complex<T>& z, const std::complex<T>& c) { return job.formula.newton(z, c); };
+    auto render_row = [&](uint32_t row, uint32_t col_begin, uint32_t col_end, uint32_t col_step, size_t sample_begin, size_t sample_end)
+    {
+        if (job.rendering_mode == NEWTON)
+        {
+            return renderRow(job, newton_step, perturbation.get(), row, col_begin, col_end, col_step, sample_begin, sample_end, data, resume);
+        }
+        if (job.formula.isQuadratic())
+        {
+            return renderRow(job, quadratic_step, perturbation.get(), row, col_begin, col_end, col_step, sample_begin, sample_end, data, resume);
+        }
+        return renderRow(job, formula_step, perturbation.get(), row, col_begin, col_end, col_step, sample_begin, sample_end, data, resume);
+    };
+
+    // Adaptive antialiasing takes one sample per pixel first and supersamples only the edges
+    const size_t samples_num = (job.antialiasing + 1) * (job.antialiasing + 1);
+    const bool adaptive = job.adaptive_antialiasing && (samples_num > 1);
+
+    // Resumed rows cost what is left of them, they are not what the next render of the fractal will take
+    RenderStats pass_stats;
+    std::atomic<size_t> promoted = 0;
+    forEachRow(job, regions, [&](const RenderRegion&, const RowSpan& span)
+    {
+        promoted += render_row(span.row, span.col_begin, span.col_end, span.col_step, 0, adaptive ? 1 : samples_num);
+    }, &pass_stats, !resume);
+
+    std::atomic<size_t> refined = 0;
+    if (adaptive)
+    {
+        const SampleLayout layout(job.size, job.layout);
+        const Palette palette(job.palette);
+        forEachRow(job, regions, [&](const RenderRegion&, const RowSpan& span)
+        {
+            const uint32_t row = span.row;
+            const uint32_t col_end = span.col_end;
+            uint32_t run_begin = col_end;
+            size_t row_promoted = 0;
+            size_t row_refined = 0;
+            for (uint32_t col = span.col_begin; col <= col_end; col += span.col_step)
+            {
+                if ((col < col_end) && isEdge(job, palette, data, col, row))
+                {
+                    run_begin = std::min(run_begin, col);
+                    ++row_refined;
+                    continue;
+                }
+                if (run_begin != col_end)
+                {
+                    row_promoted += render_row(row, run_begin, col, span.col_step, 1, samples_num);
+                    run_begin = col_end;
+                }
+                if (col < col_end)
+                {
+                    SampleData* samples = data + layout(col, row) * samples_num;
+                    std::fill(samples + 1, samples + samples_num, samples[0]);
+                }
+            }
+            promoted += row_promoted;
+            refined += row_refined;
+        }, &pass_stats, false);
+    }
+
+    if (stats != nullptr)
+    {
+        stats->pixels = 0;
+        for (const auto& region : regions)
+        {
+            stats->pixels += static_cast<size_t>(region.size.x) * region.size.y;
+        }
+        stats->promoted = std::min<size_t>(promoted, stats->pixels);
+        stats->refined = refined;
+        stats->time = pass_stats.time;
+        stats->tail = pass_stats.tail;
+    }
+}
+
+void Renderer::render(const RenderJob& job, const std::complex<double>* points, SampleData* data) const
+{
+    if (job.formula.empty())
+    {
+        return;
+    }
+
+    // One sample per point, the points are laid out as a grid of job.size
+    const double frequency = 1.0 / (1.0 + std::exp(-static_cast<double>(job.frequency)));
+    const SampleLayout layout(job.size, job.layout);
+    forEachRow(job, { { vec2u(), job.size } }, [&](const RenderRegion&, const RowSpan& span)
+    {
+        for (uint32_t col = 0; col < job.size.x; ++col)
+        {
+            const std::complex<double>& point = points[static_cast<size_t>(span.row) * job.size.x + col];
+            data[layout(col, span.row)] = (job.precision == SINGLE_PRECISION) ? pointSample<float>(job, point, frequency) :
+                                                                                pointSample<double>(job, point, frequency);
+        }
+    }, nullptr, false);
+}
+
+void Renderer::render(const RenderJob& job, const vec2dd& center, const std::complex<double>* offsets, SampleData* data) const
+{
+    if (job.formula.empty())
+    {
+        return;
+    }
+
+    const size_t samples_num = static_cast<size_t>(job.size.x) * job.size.y;
+    std::unique_ptr<Perturbation> perturbation;
+    if (IsDeepZoom(job))
+    {
+        double dc_max = 0.0;
+        for (size_t ind = 0; ind < samples_num; ++ind)
+        {
+            dc_max = std::max(dc_max, std::abs(offsets[ind]));
+        }
+        perturbation = std::make_unique<Perturbation>(center, job.itrn_max, job.limit, dc_max);
+    }
+
+    const double frequency = 1.0 / (1.0 + std::exp(-static_cast<double>(job.frequency)));
+    const SampleLayout layout(job.size, job.layout);
+    forEachRow(job, { { vec2u(), job.size } }, [&](const RenderRegion&, const RowSpan& span)
+    {
+        for (uint32_t col = 0; col < job.size.x; ++col)
+        {
+            const std::complex<double>& offset = offsets[static_cast<size_t>(span.row) * job.size.x + col];
+            SampleData& sample = data[layout(col, span.row)];
+            if (perturbation != nullptr)
+            {
+                sample = { static_cast<uint32_t>(perturbation->iterate(offset)), {}, {} };
+                continue;
+            }
+
+            const std::complex<double> point(static_cast<double>(center.x + offset.real()), static_cast<double>(center.y + offset.imag()));
+            sample = (job.precision == SINGLE_PRECISION) ? pointSample<float>(job, point, frequency) : pointSample<double>(job, point, frequency);
+        }
+    }, nullptr, false);
+}
+
+void Renderer::setCancelFlag(const std::atomic<bool>* cancel)
+{
+    cancel_ = cancel;
+}
+
+bool Renderer::cancelled() const
+{
+    return (cancel_ != nullptr) && cancel_->load(std::memory_order_relaxed);
+}
+
+size_t Renderer::threadsNum() const
+{
+    return threads_num_;
+}
+
+void Renderer::setCostPrediction(bool enabled)
+{
+    cost_prediction_ = enabled;
+}
+
+void Renderer::renderIncremental(const RenderJob& previous, const RenderJob& job, SampleData* data, RenderStats* stats) const
+{
+    // Same view up to another iteration limit, unescaped samples go on from where they stopped and a lower limit only recolors
+    const bool same_view = (previous.size == job.size) && (previous.antialiasing == job.antialiasing) &&
+        (previous.adaptive_antialiasing == job.adaptive_antialiasing) && (previous.layout == job.layout) &&
+        (previous.borders.left == job.borders.left) && (previous.borders.right == job.borders.right) &&
+        (previous.borders.bottom == job.borders.bottom) && (previous.borders.top == job.borders.top);
+    if (same_view && Resumable(previous, job))
+    {
+        if (job.itrn_max > previous.itrn_max)
+        {
+            resume(job, data, stats);
+        }
+        else if (stats != nullptr)
+        {
+            *stats = RenderStats();
+        }
+        return;
+    }
+
+    vec2i offset;
+    if (!PanOffset(previous, job, &offset))
+    {
+        render(job, data, stats);
+        return;
+    }
+
+    // New pixel (x, y) is the previous pixel (x + offset.x, y + offset.y)
+    const size_t aa = job.antialiasing + 1;
+    const size_t pixel_size = aa * aa;
+    const size_t row_size = static_cast<size_t>(job.size.x) * pixel_size;
+    const uint32_t shift_x = static_cast<uint32_t>(std::abs(offset.x));
+    const uint32_t shift_y = static_cast<uint32_t>(std::abs(offset.y));
+    const uint32_t kept_x = job.size.x - shift_x;
+    const uint32_t kept_y = job.size.y - shift_y;
+
+    // Pixels are visited so that each one is read before it is overwritten
+    const SampleLayout layout(job.size, job.layout);
+    for (uint32_t i = 0; i < kept_y; ++i)
+    {
+        uint32_t y = (offset.y >= 0) ? i : job.size.y - 1 - i;
+        uint32_t src_y = static_cast<uint32_t>(static_cast<int>(y) + offset.y);
+        if (job.layout == LINEAR_LAYOUT)
+        {
+            SampleData* dst = data + y * row_size + ((offset.x >= 0) ? 0 : shift_x * pixel_size);
+            const SampleData* src = data + src_y * row_size + ((offset.x >= 0) ? shift_x * pixel_size : 0);
+            std::memmove(dst, src, static_cast<size_t>(kept_x) * pixel_size * sizeof(SampleData));
+            continue;
+        }
+
+        for (uint32_t j = 0; j < kept_x; ++j)
+        {
+            uint32_t x = (offset.x >= 0) ? j : job.size.x - 1 - j;
+            uint32_t src_x = static_cast<uint32_t>(static_cast<int>(x) + offset.x);
+            std::copy_n(data + layout(src_x, src_y) * pixel_size, pixel_size, data + layout(x, y) * pixel_size);
+        }
+    }
+
+    std::vector<RenderRegion> regions;
+    if (shift_x != 0)
+    {
+        regions.push_back({ vec2u((offset.x > 0) ? kept_x : 0, 0), vec2u(shift_x, job.size.y) });
+    }
+    if (shift_y != 0)
+    {
+        regions.push_back({ vec2u((offset.x < 0) ? shift_x : 0, (offset.y > 0) ? kept_y : 0), vec2u(kept_x, shift_y) });
+    }
+    if (regions.empty())
+    {
+        if (stats != nullptr)
+        {
+            *stats = RenderStats();
+        }
+        return;
+    }
+    render(job, regions, data, stats);
+}
+
+Color Renderer::Shade(const RenderJob& job, const Palette& palette, const SampleData& sample)
+{
+    switch (job.rendering_mode)
+    {
+    case DEFAULT:
+    {
+        return (sample.itrn < job.itrn_max) ? palette[sample.itrn] : Color();
+    }
+    case TRACER:
+    {
+        if (sample.itrn < job.itrn_max)
+        {
+            return palette[sample.itrn];
+        }
+        const float scale = job.trace_frequency / static_cast<float>(job.itrn_max);
+        auto channel = [scale](float s) { return std::sin(std::abs(s * scale)) * 0.5F + 0.5F; };
+        return { channel(sample.sum[0]), channel(sample.sum[1]), channel(sample.sum[2]) };
+    }
+    case COMPLEX_DOMAIN:
+    {
+        return domainColor(sample.z);
+    }
+    case KALI:
+    {
+        auto channel = [](float s) { return std::cos(s) * 0.5F + 0.5F; };
+        return { channel(sample.sum[0]), channel(sample.sum[1]), channel(sample.sum[2]) };
+    }
+    case ORBIT_DENSITY:
+    {
+        // All orbits go to red, shorter ones to green and the shortest to blue
+        const float exposure = job.frequency * DENSITY_EXPOSURE;
+        auto channel = [exposure](float density) { return 1.0F - std::exp(-density * exposure); };
+        return { channel(sample.sum[0]), channel(sample.sum[1]), channel(sample.sum[2]) };
+    }
+    case DISTANCE:
+    {
+        // Estimated distance to the boundary in pixels, filaments narrower than a pixel still leave a dark line
+        if (sample.itrn >= job.itrn_max)
+        {
+            return Color();
+        }
+        const float pixel = static_cast<float>(static_cast<double>(job.borders.width()) / static_cast<double>(job.size.x));
+        const float shade = std::sqrt(std::clamp(sample.sum[0] / (DISTANCE_WIDTH * pixel), 0.0F, 1.0F));
+        return { shade, shade, shade };
+    }
+    case NEWTON:
+    {
+        return (sample.itrn < job.itrn_max) ? basinColor(sample.z, sample.itrn, sample.sum[0]) : Color();
+    }
+    case INVERSE_ITERATION:
+    {
+        // Samples reached by preimages are white
+        return (sample.itrn < job.itrn_max) ? Color{ 1.0F, 1.0F, 1.0F } : Color();
+    }
+    }
+    return {};
+}
+
+void Renderer::Colorize(const RenderJob& job, const SampleData* data, uint8_t* pixels)
+{
+    // Inverse iteration left to escape time keeps the palette
+    if ((job.rendering_mode == INVERSE_ITERATION) && !InverseIteration::Supports(job))
+    {
+        RenderJob escape_job = job;
+        escape_job.rendering_mode = DEFAULT;
+        Colorize(escape_job, data, pixels);
+        return;
+    }
+
+    // Pixels come out in rows whatever the layout of the samples, tiled samples are read tile by tile
+    const Palette palette(job.palette);
+    const SampleLayout layout(job.size, job.layout);
+    const size_t samples_num = (job.antialiasing + 1) * (job.antialiasing + 1);
+    const float samples = static_cast<float>(samples_num);
+    const vec2u block = (job.layout == TILED_LAYOUT) ? vec2u(LAYOUT_TILE_SIZE, LAYOUT_TILE_SIZE) : vec2u(job.size.x, 1);
+
+    for (uint32_t block_row = 0; block_row < job.size.y; block_row += block.y)
+    {
+        for (uint32_t block_col = 0; block_col < job.size.x; block_col += block.x)
+        {
+            for (uint32_t row = block_row; row < std::min(block_row + block.y, job.size.y); ++row)
+            {
+                for (uint32_t col = block_col; col < std::min(block_col + block.x, job.size.x); ++col)
+                {
+                    const SampleData* pixel_samples = data + layout(col, row) * samples_num;
+                    Color color;
+                    for (size_t k = 0; k < samples_num; ++k)
+                    {
+                        color += Shade(job, palette, pixel_samples[k]);
+                    }
+
+                    uint8_t* pixel = pixels + (static_cast<size_t>(row) * job.size.x + col) * 4;
+                    pixel[0] = ToByte(color.r / samples);
+                    pixel[1] = ToByte(color.g / samples);
+                    pixel[2] = ToByte(color.b / samples);
+                    pixel[3] = 255;
+                }
+            }
+        }
+    }
+}
+
+size_t Renderer::SamplesNum(const RenderJob& job)
+{
+    return SampleLayout(job.size, job.layout).pixels() * (job.antialiasing + 1) * (job.antialiasing + 1);
+}
+
+bool Renderer::IsDeepZoom(const RenderJob& job)
+{
+    return job.deep_zoom && job.formula.isQuadratic() && (job.fractal_mode == MAIN) && (job.rendering_mode == DEFAULT);
+}
+
+bool Renderer::SameFractal(const RenderJob& job1, const RenderJob& job2)
+{
+    return (job1.formula == job2.formula) && (job1.fractal_mode == job2.fractal_mode) && (job1.rendering_mode == job2.rendering_mode) &&
+        (job1.itrn_max == job2.itrn_max) && (job1.limit == job2.limit) && (job1.frequency == job2.frequency) &&
+        (job1.julia_point == job2.julia_point) && (job1.precision == job2.precision) && (job1.deep_zoom == job2.deep_zoom);
+}
+
+bool Renderer::Resumable(const RenderJob& previous, const RenderJob& job)
+{
+    // Adaptive antialiasing picks the supersampled pixels by colors that depend on the limit
+    return (previous.formula == job.formula) && (previous.fractal_mode == job.fractal_mode) && (previous.rendering_mode == job.rendering_mode) &&
+        (previous.limit == job.limit) && (previous.julia_point == job.julia_point) && (previous.precision == job.precision) &&
+        (previous.deep_zoom == job.deep_zoom) && (job.rendering_mode == DEFAULT) && (job.precision == SINGLE_PRECISION) && !IsDeepZoom(job) &&
+        !(job.adaptive_antialiasing && (job.antialiasing > 0));
+}
+
+RenderJob Renderer::SubJob(const RenderJob& job, const vec2u& position, const vec2u& size)
+{
+    const DoubleDouble size_x = static_cast<double>(job.size.x);
+    const DoubleDouble size_y = static_cast<double>(job.size.y);
+
+    RenderJob sub_job = job;
+    sub_job.size = size;
+    sub_job.borders = Borders2D<DoubleDouble>(
+        job.borders.left + job.borders.width() * DoubleDouble(position.x) / size_x,
+        job.borders.left + job.borders.width() * DoubleDouble(position.x + size.x) / size_x,
+        job.borders.top - job.borders.height() * DoubleDouble(position.y + size.y) / size_y,
+        job.borders.top - job.borders.height() * DoubleDouble(position.y) / size_y);
+    return sub_job;
+}
+
+size_t Renderer::Fingerprint(const RenderJob& job)
+{
+    std::string bytes;
+    auto append = [&bytes](const auto& value) { bytes.append(reinterpret_cast<const char*>(&value), sizeof(value)); };
+
+    append(job.formula.fingerprint());
+    append(job.fractal_mode);
+    append(job.rendering_mode);
+    append(job.itrn_max);
+    append(job.limit);
+    append(job.frequency);
+    append(job.julia_point.x);
+    append(job.julia_point.y);
+    append(job.precision);
+    append(job.deep_zoom);
+    return std::hash<std::string_view>()(bytes);
+}
+
+bool Renderer::PanOffset(const RenderJob& previous, const RenderJob& job, vec2i* offset)
+{
+    if (!SameFractal(previous, job) || (job.rendering_mode == ORBIT_DENSITY) || (job.rendering_mode == INVERSE_ITERATION) ||
+        (previous.antialiasing != job.antialiasing) || (previous.adaptive_antialiasing != job.adaptive_antialiasing) ||
+        (previous.size != job.size) || (previous.layout != job.layout) || (job.size.x == 0) || (job.size.y == 0))
+    {
+        return false;
+    }
+
+    // Same scale to within a fraction of a pixel over the whole frame
+    const double width = static_cast<double>(job.borders.width());
+    const double height = static_cast<double>(job.borders.height());
+    if ((std::abs(static_cast<double>(job.borders.width() - previous.borders.width())) / width * job.size.x > PAN_TOLERANCE) ||
+        (std::abs(static_cast<double>(job.borders.height() - previous.borders.height())) / height * job.size.y > PAN_TOLERANCE))
+    {
+        return false;
+    }
+
+    double shift_x = static_cast<double>(job.borders.left - previous.borders.left) / width * job.size.x;
+    double shift_y = static_cast<double>(previous.borders.top - job.borders.top) / height * job.size.y;
+    if ((std::abs(shift_x - std::round(shift_x)) > PAN_TOLERANCE) || (std::abs(shift_y - std::round(shift_y)) > PAN_TOLERANCE) ||
+        (std::abs(shift_x) >= job.size.x) || (std::abs(shift_y) >= job.size.y))
+    {
+        return false;
+    }
+
+    *offset = vec2i(static_cast<int>(std::round(shift_x)), static_cast<int>(std::round(shift_y)));
+    return true;
+}
@@ -0,0 +1,461 @@
+#include "Render/SamplePyramid.h"
+#include "Render/FrameSymmetry.h"
+
+#include <algorithm>
+#include <chrono>
+#include <unordered_set>
+
+namespace {
+
+inline DoubleDouble Scale(const DoubleDouble& x, int exponent)
+{
+    return { std::ldexp(x.hi, exponent), std::ldexp(x.lo, exponent) };
+}
+
+inline DoubleDouble FromInt(int64_t i)
+{
+    double hi = static_cast<double>(i);
+    return { hi, static_cast<double>(i - static_cast<int64_t>(hi)) };
+}
+
+inline int64_t FloorToInt(const DoubleDouble& x)
+{
+    DoubleDouble f = floor(x);
+    return static_cast<int64_t>(f.hi) + static_cast<int64_t>(f.lo);
+}
+
+inline int64_t FloorDiv(int64_t a, int64_t b)
+{
+    return (a >= 0) ? a / b : -((-a + b - 1) / b);
+}
+
+} // namespace
+
+SamplePyramid::SamplePyramid(size_t memory_budget) : memory_budget_(memory_budget) {}
+
+bool SamplePyramid::render(const Renderer& renderer, const RenderJob& job, uint8_t* pixels, RenderStats* stats, double time_budget)
+{
+    // Hits and misses are counted once per view, not again in the calls refining it
+    const bool new_view = !Renderer::SameFractal(job_, job) || (job_.size != job.size) || (job_.antialiasing != job.antialiasing) ||
+        !(job_.borders.left == job.borders.left) || !(job_.borders.right == job.borders.right) ||
+        !(job_.borders.bottom == job.borders.bottom) || !(job_.borders.top == job.borders.top);
+
+    // Tiles of every fractal stay cached, a fingerprint collision drops the tiles of the older one
+    ++frame_;
+    fractal_ = Renderer::Fingerprint(job);
+    auto fractal = fractals_.find(fractal_);
+    if ((fractal != fractals_.end()) && !Renderer::SameFractal(fractal->second, job))
+    {
+        std::erase_if(tiles_, [this](const auto& entry) { return entry.first.fractal == fractal_; });
+    }
+    fractals_[fractal_] = job;
+    job_ = job;
+
+    const int level = Level(job);
+    const int64_t tile_size = PYRAMID_TILE_SIZE;
+
+    // View in grid units, sample (i, j) lies at (i, j) * 2^-level
+    const DoubleDouble left = Scale(job.borders.left, level);
+    const DoubleDouble right = Scale(job.borders.right, level);
+    const DoubleDouble bottom = Scale(job.borders.bottom, level);
+    const DoubleDouble top = Scale(job.borders.top, level);
+    const int64_t i0 = FloorToInt(left);
+    const int64_t j0 = FloorToInt(top);
+    const double fx = static_cast<double>(left - FromInt(i0));
+    const double fy = static_cast<double>(top - FromInt(j0));
+    const double scale_x = static_cast<double>(job.size.x) / static_cast<double>(right - left);
+    const double scale_y = static_cast<double>(job.size.y) / static_cast<double>(top - bottom);
+
+    const int64_t tx_min = FloorDiv(i0, tile_size);
+    const int64_t tx_max = FloorDiv(FloorToInt(right), tile_size);
+    const int64_t ty_min = FloorDiv(FloorToInt(bottom), tile_size);
+    const int64_t ty_max = FloorDiv(j0, tile_size);
+
+    std::vector<TileKey> keys;
+    for (int64_t ty = ty_min; ty <= ty_max; ++ty)
+    {
+        for (int64_t tx = tx_min; tx <= tx_max; ++tx)
+        {
+            keys.push_back({ fractal_, level, tx, ty });
+        }
+    }
+
+    // Tiles closest to the centre are computed first
+    const double center_x = static_cast<double>(tx_min + tx_max) * 0.5;
+    const double center_y = static_cast<double>(ty_min + ty_max) * 0.5;
+    auto distance = [&](const TileKey& key)
+    {
+        double dx = static_cast<double>(key.x) - center_x;
+        double dy = static_cast<double>(key.y) - center_y;
+        return dx * dx + dy * dy;
+    };
+    std::sort(keys.begin(), keys.end(), [&](const TileKey& a, const TileKey& b) { return distance(a) < distance(b); });
+
+    bool complete = true;
+    RenderStats total;
+    const auto start = std::chrono::steady_clock::now();
+    for (const auto& key : keys)
+    {
+        bool cached = findTile(key) != nullptr;
+        if (new_view)
+        {
+            ++(cached ? cache_stats_.hits : cache_stats_.misses);
+        }
+        if (cached)
+        {
+            continue;
+        }
+        if (!complete || ((total.pixels != 0) && (std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() > time_budget)))
+        {
+            complete = false;
+            continue;
+        }
+        if (computeTile(renderer, key, &total) == nullptr)
+        {
+            return false;
+        }
+    }
+
+    // Box filter of the colored samples falling into each pixel
+    const Palette palette(job.palette);
+    const size_t pixels_num = static_cast<size_t>(job.size.x) * job.size.y;
+    std::vector<Color> sums(pixels_num);
+    std::vector<uint32_t> counts(pixels_num);
+
+    for (const auto& key : keys)
+    {
+        // Missing tiles are filled from finer children or upsampled from the closest coarser ancestor
+        const Tile* tile = findTile(key);
+        TileKey source = key;
+        int shift = 0;
+        if (tile == nullptr)
+        {
+            const Tile* children[4] = {};
+            for (int k = 0; k < 4; ++k)
+            {
+                children[k] = findTile({ fractal_, level + 1, 2 * key.x + (k & 1), 2 * key.y + (k >> 1) });
+            }
+            if (std::all_of(std::begin(children), std::end(children), [](const Tile* child) { return child != nullptr; }))
+            {
+                shift = -1;
+            }
+            else
+            {
+                for (shift = 1; (shift <= PYRAMID_MAX_LEVEL) && (level - shift >= -PYRAMID_MAX_LEVEL) && (tile == nullptr); ++shift)
+                {
+                    source = { fractal_, level - shift, key.x >> shift, key.y >> shift };
+                    tile = findTile(source);
+                }
+                --shift;
+                if (tile == nullptr)
+                {
+                    continue;
+                }
+            }
+        }
+
+        for (int64_t r = 0; r < tile_size; ++r)
+        {
+            int64_t j = (key.y + 1) * tile_size - 1 - r;
+            double y = std::floor((static_cast<double>(j0 - j) + fy) * scale_y);
+            if ((y < 0.0) || (y >= static_cast<double>(job.size.y)))
+            {
+                continue;
+            }
+
+            for (int64_t c = 0; c < tile_size; ++c)
+            {
+                int64_t i = key.x * tile_size + c;
+                double x = std::floor((static_cast<double>(i - i0) - fx) * scale_x);
+                if ((x < 0.0) || (x >= static_cast<double>(job.size.x)))
+                {
+                    continue;
+                }
+
+                const SampleData* sample = nullptr;
+                if (shift >= 0)
+                {
+                    sample = Sample(*tile, source, i >> shift, j >> shift);
+                }
+                else
+                {
+                    TileKey child = { fractal_, level + 1, FloorDiv(2 * i, tile_size), FloorDiv(2 * j, tile_size) };
+                    sample = Sample(*findTile(child), child, 2 * i, 2 * j);
+                }
+
+                size_t ind = static_cast<size_t>(y) * job.size.x + static_cast<size_t>(x);
+                sums[ind] += Renderer::Shade(job, palette, *sample);
+                ++counts[ind];
+            }
+        }
+    }
+
+    for (size_t ind = 0; ind < pixels_num; ++ind)
+    {
+        float count = static_cast<float>(std::max<uint32_t>(counts[ind], 1));
+        pixels[ind * 4 + 0] = ToByte(sums[ind].r / count);
+        pixels[ind * 4 + 1] = ToByte(sums[ind].g / count);
+        pixels[ind * 4 + 2] = ToByte(sums[ind].b / count);
+        pixels[ind * 4 + 3] = 255;
+    }
+
+    evictTiles();
+
+    if (stats != nullptr)
+    {
+        *stats = total;
+    }
+    return complete;
+}
+
+void SamplePyramid::clear()
+{
+    tiles_.clear();
+    fractals_.clear();
+    cache_stats_ = CacheStats();
+}
+
+void SamplePyramid::setMemoryBudget(size_t memory_budget)
+{
+    memory_budget_ = memory_budget;
+    evictTiles();
+}
+
+const CacheStats& SamplePyramid::cacheStats() const
+{
+    return cache_stats_;
+}
+
+bool SamplePyramid::Supports(const RenderJob& job)
+{
+    // Adaptive antialiasing picks samples per pixel and orbit densities and preimages depend on the whole view, none fits a shared grid
+    if (job.formula.empty() || (job.size.x == 0) || (job.size.y == 0) || !(job.borders.width() > 0.0) || !(job.borders.height() > 0.0) ||
+        (job.adaptive_antialiasing && (job.antialiasing > 0)) || (job.rendering_mode == ORBIT_DENSITY) || (job.rendering_mode == INVERSE_ITERATION))
+    {
+        return false;
+    }
+
+    int level = Level(job);
+    double magnitude = std::max({ std::abs(static_cast<double>(job.borders.left)), std::abs(static_cast<double>(job.borders.right)),
+                                  std::abs(static_cast<double>(job.borders.bottom)), std::abs(static_cast<double>(job.borders.top)) });
+    return (std::abs(level) <= PYRAMID_MAX_LEVEL) && (std::ldexp(magnitude, level) < std::ldexp(1.0, 61));
+}
+
+size_t SamplePyramid::TileKeyHash::operator()(const TileKey& key) const
+{
+    size_t x = std::hash<int64_t>()(key.x);
+    size_t y = std::hash<int64_t>()(key.y);
+    return ((x * 73856093) ^ (y * 19349663) ^ key.fractal) + static_cast<size_t>(key.level + PYRAMID_MAX_LEVEL);
+}
+
+const SamplePyramid::Tile* SamplePyramid::findTile(const TileKey& key)
+{
+    auto it = tiles_.find(key);
+    if (it == tiles_.end())
+    {
+        return nullptr;
+    }
+    it->second.last_use = frame_;
+    return &it->second.tile;
+}
+
+const SamplePyramid::Tile* SamplePyramid::computeTile(const Renderer& renderer, const TileKey& key, RenderStats* stats)
+{
+    const uint32_t size = PYRAMID_TILE_SIZE;
+    const uint32_t half = size / 2;
+    const uint32_t quarter = size / 4;
+
+    // Pixel centres of the tile job land exactly on the grid samples
+    RenderJob tile_job = job_;
+    tile_job.antialiasing = 0;
+    tile_job.size = vec2u(size, size);
+    tile_job.layout = LINEAR_LAYOUT;
+    DoubleDouble left = Scale(FromInt(key.x * size) - DoubleDouble(0.5), -key.level);
+    DoubleDouble top = Scale(FromInt((key.y + 1) * size) - DoubleDouble(0.5), -key.level);
+    DoubleDouble extent = Scale(DoubleDouble(size), -key.level);
+    tile_job.borders = Borders2D<DoubleDouble>(left, left + extent, top - extent, top);
+
+    // Same tile of the fractal under another iteration limit is carried on from its samples, the highest limit goes furthest
+    const Tile* resumed = nullptr;
+    size_t resumed_itrn = 0;
+    for (const auto& [fractal, fractal_job] : fractals_)
+    {
+        if ((fractal == key.fractal) || !Renderer::Resumable(fractal_job, tile_job) || ((resumed != nullptr) && (fractal_job.itrn_max <= resumed_itrn)))
+        {
+            continue;
+        }
+
+        if (const Tile* source = findTile({ fractal, key.level, key.x, key.y }); source != nullptr)
+        {
+            resumed = source;
+            resumed_itrn = fractal_job.itrn_max;
+        }
+    }
+
+    if (resumed != nullptr)
+    {
+        Tile tile = *resumed;
+        RenderStats tile_stats;
+        if (tile_job.itrn_max > resumed_itrn)
+        {
+            renderer.resume(tile_job, tile.data(), &tile_stats);
+        }
+        if (renderer.cancelled())
+        {
+            return nullptr;
+        }
+        stats->pixels += tile_stats.pixels;
+        stats->promoted += tile_stats.promoted;
+        stats->time += tile_stats.time;
+        stats->tail += tile_stats.tail;
+        return &tiles_.emplace(key, Entry{ std::move(tile), frame_ }).first->second.tile;
+    }
+
+    // Grid is symmetric about both axes, the mirrored tile of a symmetric fractal has all the samples but those mirroring
+    // the bottom row, and the left column for the origin, which lie in the next tile
+    const FrameSymmetry symmetry(tile_job);
+    const bool point = symmetry.pointSymmetric();
+    const TileKey mirror_key = { key.fractal, key.level, point ? -key.x - 1 : key.x, -key.y - 1 };
+    if (const Tile* mirror = symmetry.mirrored() ? findTile(mirror_key) : nullptr; mirror != nullptr)
+    {
+        Tile tile(static_cast<size_t>(size) * size);
+        for (uint32_t r = 0; r + 1 < size; ++r)
+        {
+            for (uint32_t c = point ? 1 : 0; c < size; ++c)
+            {
+                tile[static_cast<size_t>(r) * size + c] = symmetry.mirror((*mirror)[static_cast<size_t>(size - 2 - r) * size + (point ? size - c : c)]);
+            }
+        }
+
+        std::vector<RenderRegion> edges = { { vec2u(0, size - 1), vec2u(size, 1) } };
+        if (point)
+        {
+            edges.push_back({ vec2u(), vec2u(1, size - 1) });
+        }
+
+        RenderStats tile_stats;
+        renderer.render(tile_job, edges, tile.data(), &tile_stats);
+        if (renderer.cancelled())
+        {
+            return nullptr;
+        }
+        stats->pixels += tile_stats.pixels;
+        stats->promoted += tile_stats.promoted;
+        stats->time += tile_stats.time;
+        stats->tail += tile_stats.tail;
+        return &tiles_.emplace(key, Entry{ std::move(tile), frame_ }).first->second.tile;
+    }
+
+    Tile tile(static_cast<size_t>(size) * size);
+    auto sample = [&](uint32_t c, uint32_t r) -> SampleData& { return tile[static_cast<size_t>(r) * size + c]; };
+
+    // Every quadrant takes all its samples from a finer child or the even ones from the parent
+    const TileKey parent_key = { key.fractal, key.level - 1, FloorDiv(key.x, 2), FloorDiv(key.y, 2) };
+    const Tile* parent = findTile(parent_key);
+
+    std::vector<RenderRegion> regions;
+    std::vector<std::pair<TileKey, vec2u>> children;
+    for (uint32_t q = 0; q < 4; ++q)
+    {
+        vec2u corner((q & 1) * half, (q >> 1) * half);
+        TileKey child_key = { key.fractal, key.level + 1, 2 * key.x + (q & 1), 2 * key.y + 1 - (q >> 1) };
+        if (findTile(child_key) != nullptr)
+        {
+            children.emplace_back(child_key, corner);
+        }
+        else if (parent != nullptr)
+        {
+            regions.push_back({ corner, vec2u(half, quarter), vec2u(1, 2) });
+            regions.push_back({ corner + vec2u(1, 1), vec2u(quarter, quarter), vec2u(2, 2) });
+        }
+        else
+        {
+            regions.push_back({ corner, vec2u(half, half) });
+        }
+    }
+
+    RenderStats tile_stats;
+    if (!regions.empty())
+    {
+        renderer.render(tile_job, regions, tile.data(), &tile_stats);
+    }
+    if (renderer.cancelled())
+    {
+        return nullptr;
+    }
+    stats->pixels += tile_stats.pixels;
+    stats->promoted += tile_stats.promoted;
+    stats->time += tile_stats.time;
+    stats->tail += tile_stats.tail;
+
+    for (uint32_t r = 0; r < size; ++r)
+    {
+        for (uint32_t c = 0; c < size; ++c)
+        {
+            int64_t i = key.x * size + c;
+            int64_t j = (key.y + 1) * size - 1 - r;
+
+            const auto child = std::find_if(children.begin(), children.end(), [&](const auto& entry)
+            {
+                return (c >= entry.second.x) && (c < entry.second.x + half) && (r >= entry.second.y) && (r < entry.second.y + half);
+            });
+            if (child != children.end())
+            {
+                sample(c, r) = *Sample(*findTile(child->first), child->first, 2 * i, 2 * j);
+            }
+            else if ((parent != nullptr) && ((i & 1) == 0) && ((j & 1) == 0))
+            {
+                sample(c, r) = *Sample(*parent, parent_key, i >> 1, j >> 1);
+            }
+        }
+    }
+
+    return &tiles_.emplace(key, Entry{ std::move(tile), frame_ }).first->second.tile;
+}
+
+void SamplePyramid::evictTiles()
+{
+    const size_t tile_bytes = static_cast<size_t>(PYRAMID_TILE_SIZE) * PYRAMID_TILE_SIZE * sizeof(SampleData);
+    const size_t max_tiles = memory_budget_ / tile_bytes;
+
+    if (tiles_.size() > max_tiles)
+    {
+        // Least recently used first, tiles used by the current frame are kept even over the budget
+        std::vector<std::pair<uint64_t, TileKey>> uses;
+        for (const auto& [key, entry] : tiles_)
+        {
+            if (entry.last_use != frame_)
+            {
+                uses.emplace_back(entry.last_use, key);
+            }
+        }
+
+        auto excess = static_cast<ptrdiff_t>(std::min(tiles_.size() - max_tiles, uses.size()));
+        std::nth_element(uses.begin(), uses.begin() + excess, uses.end(), [](const auto& a, const auto& b) { return a.first < b.first; });
+        std::for_each(uses.begin(), uses.begin() + excess, [this](const auto& use) { tiles_.erase(use.second); });
+
+        std::unordered_set<size_t> fractals = { fractal_ };
+        for (const auto& entry : tiles_)
+        {
+            fractals.insert(entry.first.fractal);
+        }
+        std::erase_if(fractals_, [&fractals](const auto& entry) { return !fractals.contains(entry.first); });
+    }
+
+    cache_stats_.tiles = tiles_.size();
+    cache_stats_.bytes = tiles_.size() * tile_bytes;
+}
+
+int SamplePyramid::Level(const RenderJob& job)
+{
+    // Finest power of two grid with at least antialiasing^2 samples per pixel
+    double pixel_size = std::min(static_cast<double>(job.borders.width()) / job.size.x, static_cast<double>(job.borders.height()) / job.size.y);
+    return static_cast<int>(std::ceil(std::log2(static_cast<double>(job.antialiasing + 1) / pixel_size)));
+}
+
+const SampleData* SamplePyramid::Sample(const Tile& tile, const TileKey& key, int64_t i, int64_t j)
+{
+    int64_t c = i - key.x * PYRAMID_TILE_SIZE;
+    int64_t r = (key.y + 1) * PYRAMID_TILE_SIZE - 1 - j;
+    return tile.data() + static_cast<size_t>(r * PYRAMID_TILE_SIZE + c);
+}
@@ -0,0 +1,91 @@
+#include "Render/VideoStream.h"
+
+#include <algorithm>
+#include <cmath>
+#include <string>
+
+namespace {
+
+// BT.601 in studio range, which is what players assume for Y4M without a color range tag
+inline uint8_t lumaByte(float r, float g, float b)
+{
+    return static_cast<uint8_t>(std::lround(std::clamp(16.0F + 0.256788F * r + 0.504129F * g + 0.0979059F * b, 0.0F, 255.0F)));
+}
+
+inline uint8_t blueByte(float r, float g, float b)
+{
+    return static_cast<uint8_t>(std::lround(std::clamp(128.0F - 0.148223F * r - 0.290993F * g + 0.439216F * b, 0.0F, 255.0F)));
+}
+
+inline uint8_t redByte(float r, float g, float b)
+{
+    return static_cast<uint8_t>(std::lround(std::clamp(128.0F + 0.439216F * r - 0.367788F * g - 0.0714274F * b, 0.0F, 255.0F)));
+}
+
+} // namespace
+
+VideoStream::VideoStream(std::ostream& stream, uint32_t width, uint32_t height, size_t fps, size_t format) :
+    stream_(stream), width_(width), height_(height), format_(format)
+{
+    if (format_ == Y4M_VIDEO)
+    {
+        stream_ << "YUV4MPEG2 W" << width_ << " H" << height_ << " F" << std::max<size_t>(fps, 1) << ":1 Ip A1:1 C420jpeg\n";
+    }
+}
+
+bool VideoStream::good() const
+{
+    return stream_.good();
+}
+
+void VideoStream::writeFrame(const uint8_t* rgb)
+{
+    if (format_ == PPM_VIDEO)
+    {
+        stream_ << "P6\n" << width_ << " " << height_ << "\n255\n";
+        stream_.write(reinterpret_cast<const char*>(rgb), static_cast<std::streamsize>(static_cast<size_t>(width_) * height_ * 3));
+        return;
+    }
+
+    const size_t luma_size = static_cast<size_t>(width_) * height_;
+    const uint32_t chroma_x = (width_ + 1) / 2;
+    const uint32_t chroma_y = (height_ + 1) / 2;
+    const size_t chroma_size = static_cast<size_t>(chroma_x) * chroma_y;
+    planes_.resize(luma_size + 2 * chroma_size);
+
+    uint8_t* luma = planes_.data();
+    uint8_t* blue = luma + luma_size;
+    uint8_t* red = blue + chroma_size;
+
+    for (size_t ind = 0; ind < luma_size; ++ind)
+    {
+        luma[ind] = lumaByte(rgb[ind * 3], rgb[ind * 3 + 1], rgb[ind * 3 + 2]);
+    }
+
+    // Chroma of every 2x2 block is taken from its mean color
+    for (uint32_t y = 0; y < chroma_y; ++y)
+    {
+        for (uint32_t x = 0; x < chroma_x; ++x)
+        {
+            float color[3] = {};
+            float count = 0.0F;
+            for (uint32_t py = 2 * y; py < std::min(2 * y + 2, height_); ++py)
+            {
+                for (uint32_t px = 2 * x; px < std::min(2 * x + 2, width_); ++px)
+                {
+                    const uint8_t* pixel = rgb + (static_cast<size_t>(py) * width_ + px) * 3;
+                    color[0] += pixel[0];
+                    color[1] += pixel[1];
+                    color[2] += pixel[2];
+                    count += 1.0F;
+                }
+            }
+
+            blue[static_cast<size_t>(y) * chroma_x + x] = blueByte(color[0] / count, color[1] / count, color[2] / count);
+            red[static_cast<size_t>(y) * chroma_x + x] = redByte(color[0] / count, color[1] / count, color[2] / count);
+        }
+    }
+
+    stream_ << "FRAME\n";
+    stream_.write(reinterpret_cast<const char*>(planes_.data()), static_cast<std::streamsize>(planes_.size()));
+}
@@ -0,0 +1,201 @@
+#include "Render/ZoomAnimation.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+constexpr double PI = 3.14159265358979323846;
+constexpr double STRIP_PROMOTION_ULPS = 16.0;
+constexpr double MIN_PIXEL_RADIUS = 0.25;
+
+ZoomAnimation::ZoomAnimation(const RenderJob& job, double zoom, size_t frames_num) :
+    job_(job), frames_num_(std::max<size_t>(frames_num, 1)), zoom_(std::max(zoom, 1.0))
+{
+    if ((job_.size.x == 0) || (job_.size.y == 0))
+    {
+        return;
+    }
+
+    const double half_x = 0.5 * static_cast<double>(job_.size.x);
+    const double half_y = 0.5 * static_cast<double>(job_.size.y);
+    const double corner = std::hypot(half_x, half_y);
+
+    // Samples on the outer circle are a pixel apart, rows are as far apart in log radius as columns in angle
+    columns_ = static_cast<uint32_t>(std::ceil(2.0 * PI * corner));
+    step_ = 2.0 * PI / static_cast<double>(columns_);
+    max_radius_ = corner * static_cast<double>(job_.borders.height()) / static_cast<double>(job_.size.y);
+
+    // Strip position of every pixel on the first frame, later frames are the same shifted by whole rows
+    pixel_rows_.resize(static_cast<size_t>(job_.size.x) * job_.size.y);
+    pixel_columns_.resize(pixel_rows_.size());
+    for (uint32_t y = 0; y < job_.size.y; ++y)
+    {
+        for (uint32_t x = 0; x < job_.size.x; ++x)
+        {
+            const double dx = static_cast<double>(x) + 0.5 - half_x;
+            const double dy = half_y - static_cast<double>(y) - 0.5;
+            const size_t ind = static_cast<size_t>(y) * job_.size.x + x;
+
+            pixel_rows_[ind] = static_cast<float>(std::log(corner / std::max(std::hypot(dx, dy), MIN_PIXEL_RADIUS)) / step_);
+            pixel_columns_[ind] = static_cast<float>((std::atan2(dy, dx) + PI) / step_);
+        }
+    }
+    pixel_depth_ = *std::max_element(pixel_rows_.begin(), pixel_rows_.end());
+
+    // Without perturbation the points are plain doubles, the zoom stops where their spacing reaches the ulp of the center
+    if (!Renderer::IsDeepZoom(job_))
+    {
+        const vec2dd center = job_.borders.center();
+        const double magnitude = std::hypot(static_cast<double>(center.x), static_cast<double>(center.y));
+        const double spacing = max_radius_ * step_ * std::exp(-(static_cast<double>(pixel_depth_) + 3.0) * step_);
+        if (magnitude > 0.0)
+        {
+            zoom_ = std::clamp(spacing / (STRIP_PROMOTION_ULPS * std::numeric_limits<double>::epsilon() * magnitude), 1.0, zoom_);
+        }
+    }
+
+    rows_num_ = static_cast<size_t>(std::ceil(std::log(zoom_) / step_ + static_cast<double>(pixel_depth_))) + 2;
+}
+
+bool ZoomAnimation::save(const Renderer& renderer, VideoStream* stream, const std::function<void(double)>& progress)
+{
+    if ((columns_ == 0) || job_.formula.empty() || !stream->good())
+    {
+        return false;
+    }
+
+    rows_.clear();
+    first_row_ = 0;
+    strip_samples_ = 0;
+
+    std::vector<uint8_t> frame(static_cast<size_t>(job_.size.x) * job_.size.y * 3);
+    const double frame_rows = (frames_num_ > 1) ? std::log(zoom_) / step_ / static_cast<double>(frames_num_ - 1) : 0.0;
+
+    for (size_t ind = 0; ind < frames_num_; ++ind)
+    {
+        const double row_offset = frame_rows * static_cast<double>(ind);
+
+        // Rows outside of the frame are not needed anymore, the strip only moves inwards
+        const size_t first_row = static_cast<size_t>(row_offset);
+        while ((first_row_ < first_row) && !rows_.empty())
+        {
+            rows_.pop_front();
+            ++first_row_;
+        }
+        first_row_ = std::max(first_row_, first_row);
+
+        renderRows(renderer, std::min(static_cast<size_t>(row_offset + static_cast<double>(pixel_depth_)) + 2, rows_num_));
+        resampleFrame(row_offset, frame.data());
+
+        stream->writeFrame(frame.data());
+        if (!stream->good())
+        {
+            return false;
+        }
+
+        if (progress)
+        {
+            progress(static_cast<double>(ind + 1) / static_cast<double>(frames_num_));
+        }
+    }
+
+    return true;
+}
+
+size_t ZoomAnimation::stripSamples() const
+{
+    return strip_samples_;
+}
+
+double ZoomAnimation::zoom() const
+{
+    return zoom_;
+}
+
+void ZoomAnimation::renderRows(const Renderer& renderer, size_t rows_end)
+{
+    const vec2dd center = job_.borders.center();
+    const double magnitude = std::max(std::hypot(static_cast<double>(center.x), static_cast<double>(center.y)), std::numeric_limits<double>::min());
+
+    std::vector<std::complex<double>> offsets;
+    std::vector<SampleData> data;
+    std::vector<uint8_t> pixels;
+
+    while (first_row_ + rows_.size() < rows_end)
+    {
+        const size_t row_begin = first_row_ + rows_.size();
+        const uint32_t rows = static_cast<uint32_t>(std::min<size_t>(STRIP_CHUNK_ROWS, rows_num_ - row_begin));
+
+        RenderJob job = job_;
+        job.size = vec2u(columns_, rows);
+        job.antialiasing = 0;
+        job.adaptive_antialiasing = false;
+
+        // Single precision is used for as long as the sample spacing of the chunk allows it
+        const double inner_radius = max_radius_ * std::exp(-static_cast<double>(row_begin + rows) * step_);
+        if ((job.precision != SINGLE_PRECISION) &&
+            (inner_radius * step_ >= STRIP_PROMOTION_ULPS * std::numeric_limits<float>::epsilon() * magnitude))
+        {
+            job.precision = SINGLE_PRECISION;
+        }
+
+        const size_t samples_num = static_cast<size_t>(columns_) * rows;
+        offsets.resize(samples_num);
+        data.resize(Renderer::SamplesNum(job));
+        pixels.resize(samples_num * 4);
+
+        for (uint32_t row = 0; row < rows; ++row)
+        {
+            const double radius = max_radius_ * std::exp(-static_cast<double>(row_begin + row) * step_);
+            for (uint32_t col = 0; col < columns_; ++col)
+            {
+                const double angle = static_cast<double>(col) * step_ - PI;
+                offsets[static_cast<size_t>(row) * columns_ + col] = { radius * std::cos(angle), radius * std::sin(angle) };
+            }
+        }
+
+        renderer.render(job, center, offsets.data(), data.data());
+        Renderer::Colorize(job, data.data(), pixels.data());
+        strip_samples_ += samples_num;
+
+        for (uint32_t row = 0; row < rows; ++row)
+        {
+            std::vector<uint8_t>& strip_row = rows_.emplace_back(static_cast<size_t>(columns_) * 3);
+            for (uint32_t col = 0; col < columns_; ++col)
+            {
+                std::copy_n(pixels.data() + (static_cast<size_t>(row) * columns_ + col) * 4, 3, strip_row.data() + static_cast<size_t>(col) * 3);
+            }
+        }
+    }
+}
+
+void ZoomAnimation::resampleFrame(double row_offset, uint8_t* rgb) const
+{
+    const size_t pixels_num = pixel_rows_.size();
+    const size_t last_row = first_row_ + rows_.size() - 1;
+
+    for (size_t ind = 0; ind < pixels_num; ++ind)
+    {
+        const double row = std::clamp(row_offset + static_cast<double>(pixel_rows_[ind]), static_cast<double>(first_row_), static_cast<double>(last_row));
+        const double col = static_cast<double>(pixel_columns_[ind]);
+
+        const size_t row0 = std::min(static_cast<size_t>(row), last_row);
+        const size_t row1 = std::min(row0 + 1, last_row);
+        const size_t col0 = static_cast<size_t>(col) % columns_;
+        const size_t col1 = (col0 + 1) % columns_;
+        const double fy = row - static_cast<double>(row0);
+        const double fx = col - std::floor(col);
+
+        const uint8_t* p00 = rows_[row0 - first_row_].data() + col0 * 3;
+        const uint8_t* p01 = rows_[row0 - first_row_].data() + col1 * 3;
+        const uint8_t* p10 = rows_[row1 - first_row_].data() + col0 * 3;
+        const uint8_t* p11 = rows_[row1 - first_row_].data() + col1 * 3;
+
+        for (size_t k = 0; k < 3; ++k)
+        {
+            const double top = static_cast<double>(p00[k]) + (static_cast<double>(p01[k]) - static_cast<double>(p00[k])) * fx;
+            const double bottom = static_cast<double>(p10[k]) + (static_cast<double>(p11[k]) - static_cast<double>(p10[k])) * fx;
+            rgb[ind * 3 + k] = static_cast<uint8_t>(std::lround(top + (bottom - top) * fy));
+        }
+    }
+}
@@ -0,0 +1,376 @@
+#include "Render/Distributed.h"
+#include "Render/JuliaAtlas.h"
+#include "Render/Poster.h"
+#include "Render/ZoomAnimation.h"
+
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <sstream>
+
+constexpr float LIMIT = 100.0F;
+constexpr float FREQUENCY = 5.0F;
+constexpr float UPPER_BORDER = 1.3F;
+constexpr float RIGHT_LEFT_RATIO = 0.5F;
+constexpr size_t MAX_ITERATION = 500;
+constexpr double ANIMATION_SECONDS = 10.0;
+constexpr size_t ANIMATION_FPS = 30;
+
+static const vec2u OUTPUT_SIZE = { 1280, 960 };
+
+static const char* USAGE_STRING =
+    "Usage: puzabrot-render [--threads N] [--workers N] [--naive-schedule] JOB_FILE...\n"
+    "       puzabrot-render --atlas TILE [--threads N] JOB_FILE...\n"
+    "       puzabrot-render --compare-layouts [--threads N] JOB_FILE...\n"
+    "       puzabrot-render --zoom FACTOR [--seconds S] [--fps N] [--format y4m|ppm] JOB_FILE...\n"
+    "\n"
+    "Renders every job file to a PNG image without opening a window.\n"
+    "A job file has one \"key value\" pair per line, for example:\n"
+    "\n"
+    "    expression_z   z^2+c\n"
+    "    rendering_mode default\n"
+    "    borders        -2.2 0.8 -1.2 1.2\n"
+    "    itrn_max       1000\n"
+    "    antialiasing   1\n"
+    "    size           1920 1440\n"
+    "    output         thumbnail.png\n"
+    "\n"
+    "Keys not given keep the values the viewer starts with. Without an output\n"
+    "key the image is written next to the job file with the .png extension.\n"
+    "\n"
+    "  --threads N  number of threads shared by the jobs, all cores by default\n"
+    "  --workers N  render each job in N worker processes, one job at a time\n"
+    "  --naive-schedule  hand out rows in order instead of by their predicted cost\n"
+    "\n"
+    "With --atlas the image becomes a grid of Julia sets of about TILE pixels\n"
+    "each, one for every point of the view at the tile centers, and the number of\n"
+    "tiles and pixels rendered per second is reported.\n"
+    "\n"
+    "With --compare-layouts every job is rendered with linear and with tiled\n"
+    "sample buffers and nothing is written. The rendering and coloring times of\n"
+    "both layouts are reported, and whether their images are the same.\n"
+    "\n"
+    "With --zoom every job becomes a video zooming FACTOR times into the center of\n"
+    "its view, written as YUV4MPEG2 or as a stream of PPM frames. An output of \"-\"\n"
+    "writes the video to the standard output.\n"
+    "\n"
+    "  --zoom F     zoom factor between the first and the last frame\n"
+    "  --seconds S  length of the video, 10 by default\n"
+    "  --fps N      frames per second, 30 by default\n"
+    "  --format F   y4m (default) or ppm\n";
+
+struct BatchJob final
+{
+    std::string job_file;
+    std::string output;
+    RenderTask task;
+};
+
+static bool LoadJob(const std::string& job_file, const std::string& extension, BatchJob* job)
+{
+    std::ifstream file(job_file);
+    if (!file.is_open())
+    {
+        return false;
+    }
+
+    job->job_file = job_file;
+    job->output = job_file.substr(0, job_file.rfind('.')) + extension;
+
+    RenderTask& task = job->task;
+    task.job.itrn_max = MAX_ITERATION;
+    task.job.limit = LIMIT;
+    task.job.frequency = FREQUENCY;
+    task.job.size = OUTPUT_SIZE;
+
+    // The output file is a property of the batch, not of the render task
+    std::stringstream text;
+    std::string line;
+    while (std::getline(file, line))
+    {
+        std::stringstream fields(line);
+        std::string key;
+        if ((fields >> key) && (key == "output"))
+        {
+            std::getline(fields >> std::ws, job->output);
+        }
+        else
+        {
+            text << line << "\n";
+        }
+    }
+
+    if (!RenderTask::Parse(text.str(), &task) || (task.job.size.x == 0) || (task.job.size.y == 0))
+    {
+        return false;
+    }
+
+    // Same view as the one the viewer opens with
+    if (!task.has_borders)
+    {
+        Borders2D<DoubleDouble>& borders = task.job.borders;
+        DoubleDouble height = DoubleDouble(2.0 * UPPER_BORDER);
+        DoubleDouble width = height * static_cast<double>(task.job.size.x) / static_cast<double>(task.job.size.y);
+        borders = Borders2D<DoubleDouble>(-width / (RIGHT_LEFT_RATIO + 1.0), width * RIGHT_LEFT_RATIO / (RIGHT_LEFT_RATIO + 1.0),
+                                          -UPPER_BORDER, UPPER_BORDER);
+    }
+
+    return true;
+}
+
+template <typename T>
+static bool ParseNumber(const char* text, T* value)
+{
+    std::stringstream number(text);
+    return (number >> *value) && number.eof();
+}
+
+static bool SaveAnimation(const Renderer& renderer, const BatchJob& job, double zoom, double seconds, size_t fps, size_t format)
+{
+    // Frames are resampled from a strip of single points, orbit densities and preimages need the whole view
+    if ((job.task.job.rendering_mode == ORBIT_DENSITY) || (job.task.job.rendering_mode == INVERSE_ITERATION))
+    {
+        return false;
+    }
+
+    std::ofstream file;
+    if (job.output != "-")
+    {
+        file.open(job.output, std::ios::binary);
+    }
+    std::ostream& output = (job.output == "-") ? std::cout : file;
+
+    RenderJob render_job = job.task.job;
+    render_job.precision = std::max<size_t>(render_job.precision, DOUBLE_PRECISION);
+
+    VideoStream stream(output, render_job.size.x, render_job.size.y, fps, format);
+    ZoomAnimation animation(render_job, zoom, static_cast<size_t>(std::ceil(seconds * static_cast<double>(fps))));
+    bool saved = animation.save(renderer, &stream);
+    if (saved && (animation.zoom() < zoom))
+    {
+        std::clog << job.job_file << ": zoom limited to " << animation.zoom() << " by double precision\n";
+    }
+
+    output.flush();
+    return saved && output.good();
+}
+
+static bool CompareLayouts(const Renderer& renderer, const BatchJob& job)
+{
+    using Clock = std::chrono::steady_clock;
+    std::vector<uint8_t> images[2];
+    for (size_t layout : { LINEAR_LAYOUT, TILED_LAYOUT })
+    {
+        RenderJob render_job = job.task.job;
+        render_job.layout = layout;
+
+        RenderStats stats;
+        std::vector<SampleData> data(Renderer::SamplesNum(render_job));
+        renderer.render(render_job, data.data(), &stats);
+
+        std::vector<uint8_t>& pixels = images[layout];
+        pixels.resize(static_cast<size_t>(render_job.size.x) * render_job.size.y * 4);
+        const Clock::time_point start = Clock::now();
+        Renderer::Colorize(render_job, data.data(), pixels.data());
+        const double colorize_time = std::chrono::duration<double>(Clock::now() - start).count();
+
+        std::clog << "  " << ((layout == LINEAR_LAYOUT) ? "linear" : "tiled ") << ": rendering " << stats.time << " s, coloring " <<
+            colorize_time * 1e3 << " ms\n";
+    }
+    return images[LINEAR_LAYOUT] == images[TILED_LAYOUT];
+}
+
+int main(int argc, char* argv[])
+{
+    size_t threads_num = std::max(std::thread::hardware_concurrency(), 1U);
+    size_t workers_num = 0;
+    double zoom = 0.0;
+    double seconds = ANIMATION_SECONDS;
+    size_t fps = ANIMATION_FPS;
+    size_t format = Y4M_VIDEO;
+    uint32_t atlas_tile = 0;
+    bool compare_layouts = false;
+    bool cost_prediction = true;
+    std::vector<std::string> job_files;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        std::string value = (i + 1 < argc) ? argv[i + 1] : "";
+        if ((arg == "--threads") && ParseNumber(value.c_str(), &threads_num) && (threads_num > 0))
+        {
+            ++i;
+        }
+        else if ((arg == "--workers") && ParseNumber(value.c_str(), &workers_num))
+        {
+            ++i;
+        }
+        else if ((arg == "--zoom") && ParseNumber(value.c_str(), &zoom) && (zoom >= 1.0))
+        {
+            ++i;
+        }
+        else if ((arg == "--seconds") && ParseNumber(value.c_str(), &seconds) && (seconds > 0.0))
+        {
+            ++i;
+        }
+        else if ((arg == "--fps") && ParseNumber(value.c_str(), &fps) && (fps > 0))
+        {
+            ++i;
+        }
+        else if ((arg == "--atlas") && ParseNumber(value.c_str(), &atlas_tile) && (atlas_tile > 0))
+        {
+            ++i;
+        }
+        else if (arg == "--naive-schedule")
+        {
+            cost_prediction = false;
+        }
+        else if (arg == "--compare-layouts")
+        {
+            compare_layouts = true;
+        }
+        else if ((arg == "--format") && ((value == "y4m") || (value == "ppm")))
+        {
+            format = (value == "y4m") ? Y4M_VIDEO : PPM_VIDEO;
+            ++i;
+        }
+        else if ((arg.empty() || (arg[0] != '-')))
+        {
+            job_files.push_back(arg);
+        }
+        else
+        {
+            std::cerr << USAGE_STRING;
+            return (arg == "--help") || (arg == "-h") ? 0 : 1;
+        }
+    }
+
+    if (job_files.empty())
+    {
+        std::cerr << USAGE_STRING;
+        return 1;
+    }
+
+    std::vector<BatchJob> jobs;
+    size_t failed = 0;
+    for (const std::string& job_file : job_files)
+    {
+        BatchJob job;
+        if (LoadJob(job_file, (zoom == 0.0) ? ".png" : ((format == Y4M_VIDEO) ? ".y4m" : ".ppm"), &job))
+        {
+            jobs.push_back(std::move(job));
+        }
+        else
+        {
+            std::cerr << job_file << ": cannot read the job\n";
+            ++failed;
+        }
+    }
+
+    std::mutex output_mutex;
+    auto report = [&](const BatchJob& job, bool saved, const RenderStats* stats = nullptr)
+    {
+        std::lock_guard<std::mutex> lock(output_mutex);
+        if (saved)
+        {
+            std::clog << job.job_file << " -> " << job.output;
+            if ((stats != nullptr) && (stats->time > 0.0))
+            {
+                // Tail is the time threads spent waiting for the last one of each render
+                std::clog << " (rendering " << stats->time << " s, tail " << 100.0 * stats->tail / stats->time << "%)";
+            }
+            std::clog << "\n";
+        }
+        else
+        {
+            std::cerr << job.job_file << ": cannot render to " << job.output << "\n";
+            ++failed;
+        }
+    };
+
+    // Video frames follow the zoom, so the strip rows of one job are rendered with all threads
+    if (zoom != 0.0)
+    {
+        Renderer renderer(threads_num);
+        renderer.setCostPrediction(cost_prediction);
+        for (const BatchJob& job : jobs)
+        {
+            report(job, SaveAnimation(renderer, job, zoom, seconds, fps, format));
+        }
+    }
+    else if (atlas_tile != 0)
+    {
+        // Tiles of one atlas are spread over all threads, atlases are saved one after another
+        Renderer renderer(threads_num);
+        for (const BatchJob& job : jobs)
+        {
+            RenderStats stats;
+            JuliaAtlas atlas(job.task.job, atlas_tile);
+            report(job, atlas.save(renderer, job.output, &stats), &stats);
+            if (stats.time > 0.0)
+            {
+                const double tiles_num = static_cast<double>(atlas.tiles().x) * static_cast<double>(atlas.tiles().y);
+                std::clog << "  " << tiles_num << " tiles, " << tiles_num / stats.time << " tiles/s, " <<
+                    static_cast<double>(stats.pixels) / stats.time * 1e-6 << " Mpixels/s\n";
+            }
+        }
+    }
+    else if (compare_layouts)
+    {
+        // Layouts of one job are rendered one after another with all threads, so their times compare
+        Renderer renderer(threads_num);
+        renderer.setCostPrediction(cost_prediction);
+        for (const BatchJob& job : jobs)
+        {
+            std::clog << job.job_file << "\n";
+            if (!CompareLayouts(renderer, job))
+            {
+                std::cerr << job.job_file << ": linear and tiled images differ\n";
+                ++failed;
+            }
+        }
+    }
+    else if (workers_num > 0)
+    {
+        Coordinator coordinator(workers_num);
+        for (const BatchJob& job : jobs)
+        {
+            report(job, coordinator.save(job.task, job.output));
+        }
+    }
+    else
+    {
+        // Whole jobs run side by side, the threads left over go to each job's renderer
+        const size_t batch_threads_num = std::max(std::min(threads_num, jobs.size()), size_t(1));
+        Renderer renderer(std::max(threads_num / batch_threads_num, size_t(1)));
+        renderer.setCostPrediction(cost_prediction);
+        std::atomic<size_t> next_job = 0;
+
+        auto run_jobs = [&]()
+        {
+            for (size_t i = next_job++; i < jobs.size(); i = next_job++)
+            {
+                RenderStats stats;
+                bool saved = Poster(jobs[i].task.job).save(renderer, jobs[i].output, {}, &stats);
+                report(jobs[i], saved, &stats);
+            }
+        };
+
+        std::vector<std::thread> threads;
+        for (size_t i = 1; i < batch_threads_num; ++i)
+        {
+            threads.emplace_back(run_jobs);
+        }
+        run_jobs();
+
+        for (std::thread& thread : threads)
+        {
+            thread.join();
+        }
+    }
+
+    return (failed == 0) ? 0 : 1;
+}